@@ -105,6 +105,16 @@ void Area::setName(std::string lang, std::string name){
     }
 }
 
+/*
+  This function retrieves the names of the Area, without copying them.
+
+  @return
+    A map of each three-letter language code to the name in that language
+*/
+const std::map<std::string, std::string>& Area::getNames() const{
+    return this->lang;
+}
+
 /*
     This function checks if the string input contains a number
 
@@ -166,13 +176,70 @@ Measure& Area::getMeasure(std::string key){
   @return
     void
 */
-void Area::setMeasure(std::string codename, Measure& measure){
+void Area::setMeasure(std::string codename, const Measure& measure){
     // Converting the codename to lowercase
     std::transform(codename.begin(), codename.end(), codename.begin(), ::tolower);
     this->measures[codename] = measure;
     //this->measures.insert({codename, measure});
 }
 
+/*
+  This function adds a particular Measure to this Area object, moving it
+  into the Area rather than copying it (and all its values). See the other
+  overload of setMeasure() for how the codename is stored.
+
+  @param codename
+    The codename for the Measure
+
+  @param measure
+    The Measure object, which is moved from
+
+  @return
+    void
+*/
+void Area::setMeasure(std::string codename, Measure&& measure){
+    std::transform(codename.begin(), codename.end(), codename.begin(), ::tolower);
+    this->measures[codename] = std::move(measure);
+}
+
+/*
+  This function retrieves the Measure with a given codename, creating it
+  with the given label if this Area does not have it yet. A Measure that
+  already exists keeps its label.
+
+  @param codename
+    The codename for the Measure, which will be converted to lowercase
+
+  @param label
+    Human-readable label for the Measure, if it is created
+
+  @return
+    The Measure
+
+  @example
+    Area area("W06000023");
+    area.emplaceMeasure("Pop", "Population").setValue(2011, 132976);
+*/
+Measure& Area::emplaceMeasure(std::string codename, const std::string &label){
+    std::transform(codename.begin(), codename.end(), codename.begin(), ::tolower);
+    auto it = this->measures.lower_bound(codename);
+    if(it == this->measures.end() || it->first != codename){
+        it = this->measures.emplace_hint(it, codename, Measure(codename, label));
+    }
+    return it->second;
+}
+
+/*
+  This function retrieves all the Measures of this Area, without copying
+  them.
+
+  @return
+    A map of each codename to its Measure
+*/
+const std::map<std::string, Measure>& Area::getMeasures() const{
+    return this->measures;
+}
+
 /*
   This function gets the number of Measures we have for this Area
 
@@ -47,11 +47,15 @@ public:
   void setLocalAuthorityCode(std::string localAuthorityCode);
   std::string getName(std::string lang) const;
   void setName(std::string lang, std::string name);
+  const std::map<std::string, std::string>& getNames() const;
 
   bool containsNumber(std::string lang);
 
-  void setMeasure(std::string codename, Measure& measure);
+  void setMeasure(std::string codename, const Measure& measure);
+  void setMeasure(std::string codename, Measure&& measure);
+  Measure& emplaceMeasure(std::string codename, const std::string &label);
   Measure& getMeasure(std::string key);
+  const std::map<std::string, Measure>& getMeasures() const;
 
   unsigned int size() const;
 
@@ -18,25 +18,47 @@
   must implement has a TODO block comment. 
 */
 
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 #include <string>
 #include <stdexcept>
 #include <tuple>
 #include <unordered_set>
-#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "lib_json.hpp"
 
 #include "datasets.h"
 #include "areas.h"
+#include "authoritycodes.h"
+#include "csvscan.h"
+#include "input.h"
+#include "jsonindex.h"
+#include "jsonscan.h"
 #include "measure.h"
+#include "numeric.h"
+#include "recordbatch.h"
+#include "recordindex.h"
 
 /*
   An alias for the imported JSON parsing library.
 */
 using json = nlohmann::json;
 
+/*
+  The smallest chunk of a StatsWales JSON file that is imported on a thread
+  of its own. Smaller files are not worth splitting.
+*/
+const std::size_t MIN_JSON_CHUNK_SIZE = 64 * 1024;
+
+/*
+  The ID in a RecordBatch of an area that is not in it.
+*/
+const RecordBatch::ID NOT_BATCHED = ~RecordBatch::ID(0);
+
 /*
   Constructor for an Areas object.
 
@@ -47,6 +69,61 @@ Areas::Areas() {
   //throw std::logic_error("Areas::Areas() has not been implemented!");
 }
 
+/*
+  This function sets the backend used by populateFromWelshStatsJSON() to read
+  StatsWales JSON files.
+
+  @param backend
+    The JSONBackend to use
+
+  @example
+    Areas data = Areas();
+    data.setJSONBackend(JSONBackend::DOM);
+*/
+void Areas::setJSONBackend(JSONBackend backend){
+    this->jsonBackend = backend;
+}
+
+/*
+  This function gets the backend used by populateFromWelshStatsJSON() to read
+  StatsWales JSON files.
+
+  @return
+    The JSONBackend in use
+*/
+JSONBackend Areas::getJSONBackend() const{
+    return this->jsonBackend;
+}
+
+/*
+  This function sets the number of threads used by populateFromWelshStatsJSON()
+  to read a StatsWales JSON file, with the Scan and SIMD backends.
+
+  @param threads
+    The number of threads to use, or 0 to use one per CPU core
+
+  @example
+    Areas data = Areas();
+    data.setThreads(4);
+*/
+void Areas::setThreads(unsigned int threads){
+    if(threads == 0){
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    this->threads = threads;
+}
+
+/*
+  This function gets the number of threads used by populateFromWelshStatsJSON()
+  to read a StatsWales JSON file.
+
+  @return
+    The number of threads
+*/
+unsigned int Areas::getThreads() const{
+    return this->threads;
+}
+
 /*
   This function adds a particular Area to the Areas object.
 
@@ -64,10 +141,51 @@ Areas::Areas() {
   @return
     void
 */
-void Areas::setArea(std::string localAuthorityCode, Area &area){
+void Areas::setArea(std::string localAuthorityCode, const Area &area){
     areasContainer[localAuthorityCode] = area;
 }
 
+/*
+  This function adds a particular Area to the Areas object, moving it into
+  the container rather than copying it (and all its Measures). See the other
+  overload of setArea() for how an existing Area is replaced.
+
+  @param localAuthorityCode
+    The local authority code of the Area
+
+  @param area
+    The Area object, which is moved from
+
+  @return
+    void
+*/
+void Areas::setArea(std::string localAuthorityCode, Area &&area){
+    areasContainer[localAuthorityCode] = std::move(area);
+}
+
+/*
+  This function retrieves the Area with a given local authority code,
+  creating an Area with the code (and no names or Measures) if there is not
+  one yet.
+
+  @param localAuthorityCode
+    The local authority code of the Area
+
+  @return
+    The Area
+
+  @example
+    Areas data = Areas();
+    data.emplaceArea("W06000023").setName("eng", "Powys");
+*/
+Area& Areas::emplaceArea(const std::string &localAuthorityCode){
+    auto it = areasContainer.lower_bound(localAuthorityCode);
+    if(it == areasContainer.end() || it->first != localAuthorityCode){
+        it = areasContainer.emplace_hint(it, localAuthorityCode, Area(localAuthorityCode));
+    }
+    return it->second;
+}
+
 
 /*
   This function retrieves an Area instance with a given local authority code.
@@ -100,6 +218,10 @@ AreasContainer& Areas::getAreaContainer() {
     return this->areasContainer;
 }
 
+const AreasContainer& Areas::getAreaContainer() const {
+    return this->areasContainer;
+}
+
 
 /*
   This function retrieves the number of Areas within the container.
@@ -112,6 +234,18 @@ unsigned int Areas::size() const{
 }
 
 
+/*
+  This function imports the areas in areas.csv into this Areas object. See
+  the overload below, which passes them to any RecordSink.
+*/
+void Areas::populateFromAuthorityCodeCSV(
+    std::istream &is,
+    const BethYw::SourceColumnMapping &cols,
+    const StringFilterSet * const areasFilter) {
+    AreasSink sink(areasContainer);
+    populateFromAuthorityCodeCSV(is, cols, sink, areasFilter);
+}
+
 /*
   This function specifically parses the compiled areas.csv file of local 
   authority codes, and their names in English and Welsh.
@@ -121,7 +255,8 @@ unsigned int Areas::size() const{
   data.
 
   Once the data is parsed, Area objects will be created accordingly and
-  insert them in to areasContainer.
+  passed to a RecordSink in batches (e.g. an AreasSink, which inserts them
+  in to an AreasContainer).
 
   @param is
     The input stream from InputSource
@@ -130,6 +265,9 @@ unsigned int Areas::size() const{
     A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
     that give the column header in the CSV file
 
+  @param sink
+    The sink to pass the areas, measures and values read to, in batches
+
   @param areasFilter
     An umodifiable pointer to set of umodifiable strings for areas to import,
     or an empty set if all areas should be imported
@@ -150,17 +288,18 @@ unsigned int Areas::size() const{
 void Areas::populateFromAuthorityCodeCSV(
     std::istream &is,
     const BethYw::SourceColumnMapping &cols,
+    RecordSink &sink,
     const StringFilterSet * const areasFilter) {
 
-    // Getting the first line of the csv file which is the heading
-    std::string str;
-    std::getline(is, str);
-    std::stringstream sstream(str);
+    // Getting the first row of the csv file which is the heading
+    CSVScanner scanner(is);
     std::vector<std::string> headings;
-    while(sstream.good()){
-        std::string substr;
-        getline(sstream, substr, ',');
-        headings.push_back(substr);
+    if(scanner.nextRow()){
+        for(unsigned int i = 0; i < scanner.size(); i++){
+            headings.push_back(scanner[i].str());
+        }
+    } else {
+        headings.push_back("");
     }
 
     // There should be only three elements in our headings vector, if there are
@@ -174,39 +313,1098 @@ void Areas::populateFromAuthorityCodeCSV(
         // 0 = Local Authority Code, 1 = Name (eng), 2 = Name (cym)
     }
 
-    /* Start reading every line of the csv file and create
-     * area's object accordingly
+    /* Start reading every row of the csv file and create
+     * area's object accordingly. The areas are added in batches, and the
+     * rows read before a malformed one are still added
     */
-    while(is.good()) {
-        std::getline(is, str);
-
-        // Vector for storing data
-        std::vector<std::string> values;      // Index: 0 = area code, 1 = eng, 2 = cym
-        std::stringstream ss(str);
+    RecordBatch batch;
+    std::string localAuthorityCode;
+    try{
+        while(scanner.nextRow()) {
+            // Check if the area code in the first column is in our areafilters,
+            // if not, we ignore the row without copying the rest of it
+            localAuthorityCode.assign(scanner[0].begin(), scanner[0].end());
+            if (areasFilter != NULL && !areasFilter->empty() &&
+                areasFilter->find(localAuthorityCode) == areasFilter->end()) {
+                continue;
+            }
 
-        // Reading data and store it in our values vector
-        while (ss.good()) {
-            std::string substr;
-            getline(ss, substr, ',');
-            values.push_back(substr);
-        }
+            // Index: 0 = area code, 1 = eng, 2 = cym
+            if (scanner.size() < 3) {
+                throw std::runtime_error("Parsing error occurs: due to malformed file");
+            }
 
-        // Check if it is in our areafilters, if not, we ignore, it. Otherwise, we create area object
-        if (areasFilter != NULL && areasFilter->find(values[0]) == areasFilter->end() && !areasFilter->empty()) {
-            continue;
-        } else {
-            Area *area = new Area(values[0]);
+            // Otherwise, we create area object, which replaces any Area that
+            // already has the code
+            RecordBatch::ID area = batch.replaceArea(localAuthorityCode);
             //std::string langCodeEnglish  = cols.at(BethYw::SourceColumn::AUTH_NAME_ENG);
             std::string langCodeEnglish = "eng";
-            area->setName(langCodeEnglish, values[1]);
+            batch.setName(area, langCodeEnglish, scanner[1].str());
 
             //std::string langCodeWelsh  = cols.at(BethYw::SourceColumn::AUTH_NAME_CYM);
             std::string langCodeWelsh = "cym";
-            area->setName(langCodeWelsh, values[2]);
+            batch.setName(area, langCodeWelsh, scanner[2].str());
 
-            areasContainer[values[0]] = *area;
+            if(batch.full()){
+                sink.consume(batch);
+                batch.clear();
+            }
         }
+    } catch(const std::exception&){
+        sink.consume(batch);
+        throw;
     }
+    sink.consume(batch);
+}
+
+/*
+  A single value read from a StatsWales JSON record.
+*/
+struct WelshStatsField {
+    // Whether the record contained a (non-null) value for the column
+    bool present = false;
+
+    // Whether the value was a JSON string, rather than a number or literal
+    bool isString = false;
+
+    // The decoded string, or the raw text of a number or literal
+    std::string text;
+};
+
+/*
+  The values of a single StatsWales JSON record (i.e. one element of the
+  "value" array), indexed by the BethYw::SourceColumn they are mapped to.
+
+  The strings are kept between records, so once a few records have been read
+  no further memory needs to be allocated to read the rest of the file.
+*/
+class WelshStatsRecord {
+private:
+    WelshStatsField fields[BethYw::SourceColumn::VALUE + 1];
+
+public:
+    WelshStatsField& operator[](BethYw::SourceColumn column){
+        return fields[column];
+    }
+
+    /*
+      Get the value of a column, throwing std::out_of_range if the record did
+      not contain it.
+    */
+    bool has(BethYw::SourceColumn column) const{
+        return fields[column].present;
+    }
+
+    const std::string& get(BethYw::SourceColumn column) const{
+        if(!fields[column].present){
+            throw std::out_of_range("There are not enough columns in cols");
+        }
+        return fields[column].text;
+    }
+
+    void clear(){
+        for(auto &field : fields){
+            field.present = false;
+        }
+    }
+};
+
+/*
+  The keys of a StatsWales JSON record needed by WelshStatsImporter,
+  built from the SourceColumnMapping of a dataset. Every other key of a record
+  (e.g. *_SortOrder, *_Hierarchy, RowKey) can be skipped without being decoded.
+*/
+class WelshStatsProjection {
+private:
+    // Each key that is needed, with the columns it is mapped to (a dataset may
+    // map more than one column to the same key)
+    std::vector<std::pair<std::string, std::vector<BethYw::SourceColumn>>> keys;
+
+public:
+    explicit WelshStatsProjection(const BethYw::SourceColumnMapping& cols){
+        const BethYw::SourceColumn columns[] = { BethYw::SourceColumn::AUTH_CODE,
+                                                 BethYw::SourceColumn::AUTH_NAME_ENG,
+                                                 BethYw::SourceColumn::MEASURE_CODE,
+                                                 BethYw::SourceColumn::MEASURE_NAME,
+                                                 BethYw::SourceColumn::YEAR,
+                                                 BethYw::SourceColumn::VALUE };
+
+        for(auto column : columns){
+            auto col = cols.find(column);
+            if(col == cols.end()){
+                continue;
+            }
+
+            auto key = std::find_if(keys.begin(), keys.end(), [&col](const auto &key){
+                return key.first == col->second;
+            });
+            if(key == keys.end()){
+                keys.emplace_back(col->second, std::vector<BethYw::SourceColumn>{column});
+            } else {
+                key->second.push_back(column);
+            }
+        }
+    }
+
+    /*
+      Find the columns mapped to a key, or nullptr if the key is not needed.
+    */
+    const std::vector<BethYw::SourceColumn>* find(const std::string& key) const{
+        for(auto &entry : keys){
+            if(entry.first == key){
+                return &entry.second;
+            }
+        }
+        return nullptr;
+    }
+
+    /*
+      Store a value in the record for the first of `columns`, and copy it to
+      any other columns mapped to the same key.
+    */
+    void store(const std::vector<BethYw::SourceColumn>& columns,
+               WelshStatsRecord& record,
+               std::string&& text,
+               bool isString) const{
+        WelshStatsField &field = record[columns.front()];
+        field.text = std::move(text);
+        field.isString = isString;
+        field.present = true;
+        copy(columns, record);
+    }
+
+    /*
+      Copy the value stored for the first of `columns` to the others.
+    */
+    void copy(const std::vector<BethYw::SourceColumn>& columns,
+              WelshStatsRecord& record) const{
+        for(size_t i = 1; i < columns.size(); i++){
+            record[columns[i]] = record[columns.front()];
+        }
+    }
+};
+
+/*
+  This function adds the areas, measures and values of a RecordBatch to an
+  AreasContainer, with the same result as adding each of them in turn in
+  the order they were added to the batch (see recordbatch.h).
+
+  Each area and measure in the batch is looked up (or created) once, after
+  which its values are set through a pointer to it.
+
+  @param areasContainer
+    The container to add the batch to
+
+  @param batch
+    The batch
+*/
+static void ingestRecordBatch(AreasContainer& areasContainer, const RecordBatch& batch){
+    const std::vector<RecordBatch::AreaEntry> &areaEntries = batch.getAreas();
+    std::vector<Area *> areas(areaEntries.size());
+    for(std::size_t i = 0; i < areaEntries.size(); i++){
+        const RecordBatch::AreaEntry &entry = areaEntries[i];
+        auto it = areasContainer.lower_bound(entry.code);
+        bool exists = it != areasContainer.end() && it->first == entry.code;
+        if(exists && !entry.replace){
+            areas[i] = &it->second;
+            continue;
+        }
+
+        Area area;
+        if(entry.named){
+            area.setLocalAuthorityCode(entry.code);
+            for(const auto &name : entry.names){
+                area.setName(name.first, name.second);
+            }
+        }
+        if(exists){
+            it->second = std::move(area);
+        } else {
+            it = areasContainer.emplace_hint(it, entry.code, std::move(area));
+        }
+        areas[i] = &it->second;
+    }
+
+    const std::vector<RecordBatch::MeasureEntry> &measureEntries = batch.getMeasures();
+    std::vector<Measure *> measures(measureEntries.size());
+    for(std::size_t i = 0; i < measureEntries.size(); i++){
+        const RecordBatch::MeasureEntry &entry = measureEntries[i];
+        measures[i] = &areas[entry.area]->emplaceMeasure(entry.codename, entry.label);
+    }
+
+    const std::vector<RecordBatch::ID> &measureColumn = batch.getMeasureColumn();
+    const std::vector<int> &yearColumn = batch.getYearColumn();
+    const std::vector<double> &valueColumn = batch.getValueColumn();
+    for(std::size_t i = 0; i < valueColumn.size(); i++){
+        measures[measureColumn[i]]->setValue(yearColumn[i], valueColumn[i]);
+    }
+}
+
+/*
+  Construct a sink that adds batches of records to an AreasContainer.
+
+  @param areasContainer
+    The container to add the batches to
+*/
+AreasSink::AreasSink(AreasContainer &areasContainer) : areasContainer(areasContainer) {}
+
+/*
+  This function adds a batch of records to the container (see
+  ingestRecordBatch()).
+
+  @param batch
+    The batch
+*/
+void AreasSink::consume(const RecordBatch &batch){
+    ingestRecordBatch(areasContainer, batch);
+}
+
+/*
+  These functions test whether the container already has an area, or a
+  measure of an area, so that a parser does not need to read its names or
+  label again.
+*/
+bool AreasSink::contains(const std::string &code) const{
+    return areasContainer.find(code) != areasContainer.end();
+}
+
+bool AreasSink::contains(const std::string &code, const std::string &codename) const{
+    auto it = areasContainer.find(code);
+    return it != areasContainer.end() && it->second.measures.find(codename) != it->second.measures.end();
+}
+
+/*
+  This function passes the areas of an AreasContainer to a RecordSink, with
+  the same result as if the records they were imported from had been passed
+  to it instead. The areas are batched whole, so a batch only becomes larger
+  than its capacity if a single area has more values than that.
+
+  @param areasContainer
+    The areas to pass to the sink
+
+  @param sink
+    The sink
+*/
+static void sendAreasContainer(const AreasContainer& areasContainer, RecordSink& sink){
+    RecordBatch batch;
+    for(const auto& entry : areasContainer){
+        if(batch.full()){
+            sink.consume(batch);
+            batch.clear();
+        }
+
+        RecordBatch::ID area = batch.addArea(entry.first);
+        for(const auto& name : entry.second.getNames()){
+            batch.setName(area, name.first, name.second);
+        }
+        for(const auto& measureEntry : entry.second.getMeasures()){
+            const Measure &measure = measureEntry.second;
+            RecordBatch::ID id = batch.addMeasure(area, measureEntry.first, measure.getLabel());
+            for(const auto value : measure.getValues()){
+                batch.addValue(id, value.first, value.second);
+            }
+        }
+    }
+    if(!batch.empty()){
+        sink.consume(batch);
+    }
+}
+
+/*
+  WelshStatsImporter imports the records (i.e. the elements of the "value"
+  array) of a StatsWales JSON file into a RecordSink. It is shared by all
+  the JSON backends of Areas::populateFromWelshStatsJSON() so that they all
+  import exactly the same data.
+
+  The filters are applied as soon as the column they test has been read:
+  complete() tells a backend when every value still needed from a record has
+  been read, so that the rest of the record can be skipped. For example, a
+  record for an area not in areasFilter can be skipped as soon as its
+  authority code is known.
+
+  Records are imported into a RecordBatch, which is passed to a RecordSink
+  (e.g. an AreasSink) whenever it is full and by finish(), so each area and
+  measure is only looked up in the sink once per batch. The
+  authority code of each record is interned (see AuthorityCodes), so testing
+  it against areasFilter and finding its area are both done by its ID.
+*/
+class WelshStatsImporter {
+private:
+    RecordSink& sink;
+    AuthorityCodes codes;
+    const StringFilterSet * const measuresFilter;
+
+    // Whether the sink has the area of each interned code, by its ID. Codes
+    // are looked up in the sink when they are first needed, and after that
+    // only this importer adds areas to it.
+    std::vector<bool> sunk;
+
+    // The records imported since the batch was last passed to the sink, and
+    // the ID in it of the area of each interned code, or NOT_BATCHED
+    RecordBatch batch;
+    std::vector<RecordBatch::ID> batched;
+
+    int minYear = 0;
+    int maxYear = 0;
+
+    // Since some datasets does not have MEASURE_CODE or MEASURE_NAME in the
+    // JSON file, we replace them with SINGLE_MEASURE_CODE and
+    // SINGLE_MEASURE_NAME that were set in the datasets.h
+    const bool hasMeasureCode;
+    const bool hasMeasureName;
+    std::string singleMeasureCode;
+    std::string singleMeasureName;
+
+    // What is known so far about the record currently being read, including
+    // whether its area and measure already exist (in the sink or the batch),
+    // in which case their names and labels are not needed
+    bool areaResolved = false;
+    bool areaAccepted = false;
+    bool areaKnown = false;
+    AuthorityCodes::ID areaID = 0;
+
+    bool measureResolved = false;
+    bool measureAccepted = false;
+    bool measureKnown = false;
+    std::string measureCode;
+
+    bool yearResolved = false;
+    bool yearAccepted = false;
+    int year = 0;
+
+    /*
+      Check the authority code of the record against areasFilter, and find
+      whether its Area already exists.
+    */
+    void resolveArea(const WelshStatsRecord& record){
+        if(areaResolved){
+            return;
+        }
+        areaID = codes.intern(record.get(BethYw::SourceColumn::AUTH_CODE));
+        areaAccepted = codes.accepted(areaID);
+        if(areaAccepted){
+            while(sunk.size() <= areaID){
+                sunk.push_back(sink.contains(codes.code(sunk.size())));
+                batched.push_back(NOT_BATCHED);
+            }
+            areaKnown = sunk[areaID] || batched[areaID] != NOT_BATCHED;
+        }
+        areaResolved = true;
+    }
+
+    /*
+      Check the (lowercase) measure code of the record against measuresFilter,
+      and find whether its Measure already exists.
+    */
+    void resolveMeasure(const WelshStatsRecord& record){
+        if(measureResolved){
+            return;
+        }
+        if(hasMeasureCode){
+            measureCode = record.get(BethYw::SourceColumn::MEASURE_CODE);
+            std::transform(measureCode.begin(), measureCode.end(), measureCode.begin(), ::tolower);
+        } else {
+            measureCode = singleMeasureCode;
+        }
+        measureAccepted = measuresFilter == nullptr || measuresFilter->empty() ||
+                          measuresFilter->find(measureCode) != measuresFilter->end();
+        if(measureAccepted && areaKnown){
+            RecordBatch::ID measure;
+            measureKnown = (batched[areaID] != NOT_BATCHED &&
+                            batch.findMeasure(batched[areaID], measureCode, measure)) ||
+                           (sunk[areaID] && sink.contains(codes.code(areaID), measureCode));
+        }
+        measureResolved = true;
+    }
+
+    /*
+      Check the year of the record against yearsFilter.
+    */
+    void resolveYear(const WelshStatsRecord& record){
+        if(yearResolved){
+            return;
+        }
+        const std::string &text = record.get(BethYw::SourceColumn::YEAR);
+        if(!BethYw::decodeInt(text, year)){
+            throw std::runtime_error("Invalid year: " + text);
+        }
+        yearAccepted = (year >= minYear && year <= maxYear) || (minYear == 0 && maxYear == 0);
+        yearResolved = true;
+    }
+
+public:
+    WelshStatsImporter(RecordSink& sink,
+                       const BethYw::SourceColumnMapping& cols,
+                       const StringFilterSet * const areasFilter,
+                       const StringFilterSet * const measuresFilter,
+                       const YearFilterTuple * const yearsFilter)
+        : sink(sink), codes(areasFilter),
+          measuresFilter(measuresFilter),
+          hasMeasureCode(cols.find(BethYw::SourceColumn::MEASURE_CODE) != cols.end()),
+          hasMeasureName(cols.find(BethYw::SourceColumn::MEASURE_NAME) != cols.end()) {
+        if(yearsFilter != nullptr){
+            std::tie(minYear, maxYear) = *yearsFilter;
+        }
+        if(!hasMeasureCode){
+            singleMeasureCode = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_CODE);
+            std::transform(singleMeasureCode.begin(), singleMeasureCode.end(),
+                           singleMeasureCode.begin(), ::tolower);
+        }
+        if(!hasMeasureName){
+            singleMeasureName = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_NAME);
+        }
+    }
+
+    WelshStatsImporter(const WelshStatsImporter&) = delete;
+    WelshStatsImporter& operator=(const WelshStatsImporter&) = delete;
+
+    /*
+      If reading the file failed part way through, the records imported
+      before the failure are still passed to the sink, just as if they
+      had been added one at a time.
+    */
+    ~WelshStatsImporter(){
+        try{
+            finish();
+        } catch(const std::exception&){
+        }
+    }
+
+    /*
+      Pass the records imported so far to the sink.
+    */
+    void finish(){
+        if(batch.empty()){
+            return;
+        }
+        sink.consume(batch);
+        for(std::size_t id = 0; id < batched.size(); id++){
+            if(batched[id] != NOT_BATCHED){
+                sunk[id] = true;
+                batched[id] = NOT_BATCHED;
+            }
+        }
+        batch.clear();
+    }
+
+    /*
+      Forget everything known about the previous record, ready to read the next.
+    */
+    void begin(){
+        areaResolved = measureResolved = yearResolved = false;
+        areaKnown = measureKnown = false;
+        if(batch.full()){
+            finish();
+        }
+    }
+
+    /*
+      Determine whether every value import() needs from the record being read
+      has been read, applying the filters to the values read so far.
+
+      @param record
+        The values read so far for the current record
+
+      @return
+        true if the rest of the record can be skipped, false otherwise
+    */
+    bool complete(const WelshStatsRecord& record){
+        if(!record.has(BethYw::SourceColumn::AUTH_CODE)){
+            return false;
+        }
+        resolveArea(record);
+        if(!areaAccepted){
+            return true;
+        }
+        // A new Area needs its English name
+        if(!areaKnown && !record.has(BethYw::SourceColumn::AUTH_NAME_ENG)){
+            return false;
+        }
+
+        if(hasMeasureCode && !record.has(BethYw::SourceColumn::MEASURE_CODE)){
+            return false;
+        }
+        resolveMeasure(record);
+        if(!measureAccepted){
+            return true;
+        }
+        // A new Measure needs its label
+        if(!measureKnown && hasMeasureName && !record.has(BethYw::SourceColumn::MEASURE_NAME)){
+            return false;
+        }
+
+        if(!record.has(BethYw::SourceColumn::YEAR)){
+            return false;
+        }
+        resolveYear(record);
+        return !yearAccepted || record.has(BethYw::SourceColumn::VALUE);
+    }
+
+    /*
+      Import the record being read.
+
+      If the area of the record is in areasFilter (or it is empty), the Area is
+      created if it does not exist. If its measure is also in measuresFilter
+      (or it is empty), the Measure is created if it does not exist. Finally,
+      if its year is within yearsFilter (or it is <0,0>), the value is set.
+
+      @param record
+        The values of the record
+
+      @throws
+        std::out_of_range if there are not enough columns in cols
+    */
+    void import(const WelshStatsRecord& record){
+        resolveArea(record);
+        if(!areaAccepted){
+            return;
+        }
+
+        // If the area is not currently in the sink, it is created
+        // with the local authority code and name of the record
+        RecordBatch::ID &batchArea = batched[areaID];
+        if(batchArea == NOT_BATCHED){
+            const std::string &localAuthorityCode = codes.code(areaID);
+            batchArea = areaKnown
+                        ? batch.addArea(localAuthorityCode)
+                        : batch.addArea(localAuthorityCode, "eng",
+                                        record.get(BethYw::SourceColumn::AUTH_NAME_ENG));
+        }
+
+        resolveMeasure(record);
+        if(!measureAccepted){
+            return;
+        }
+
+        // If the measure is not currently in our area, it is created with
+        // the label of the record. A measure that already exists keeps its
+        // label, which may not have been read.
+        RecordBatch::ID measure;
+        if(!batch.findMeasure(batchArea, measureCode, measure)){
+            const std::string &label = !measureKnown && hasMeasureName
+                                       ? record.get(BethYw::SourceColumn::MEASURE_NAME)
+                                       : singleMeasureName;
+            measure = batch.addMeasure(batchArea, measureCode, label);
+        }
+
+        // If year is within the yearFilter time frame and if the yearFilter is
+        // <0,0>, we save the data to our measure object. Data is either a
+        // number or, in some datasets, a number encoded as a string.
+        resolveYear(record);
+        if(yearAccepted){
+            const std::string &text = record.get(BethYw::SourceColumn::VALUE);
+            double value;
+            if(!BethYw::decodeDouble(text, value)){
+                throw std::runtime_error("Invalid value: " + text);
+            }
+            batch.addValue(measure, year, value);
+        }
+    }
+};
+
+/*
+  A SAX handler for the nlohmann JSON library which imports each record of
+  the "value" array of a StatsWales JSON file as soon as it has been
+  tokenized, instead of waiting for the whole document to be parsed.
+
+  Only the record currently being read (and the batch of records imported
+  before it, see WelshStatsImporter) is held in memory, so the memory used
+  is independent of the size of the file.
+*/
+class WelshStatsSAXHandler : public nlohmann::json_sax<json> {
+private:
+    WelshStatsImporter importer;
+    const WelshStatsProjection projection;
+
+    // How deeply nested the parser currently is (the document object is 1)
+    unsigned int depth = 0;
+    // True whilst the parser is inside the top-level "value" array
+    bool inRecords = false;
+    // The most recently read key
+    std::string currentKey;
+    // The columns the most recently read key of a record is mapped to
+    const std::vector<BethYw::SourceColumn>* currentColumns = nullptr;
+    // The record currently being read
+    WelshStatsRecord record;
+
+    /*
+      Store a scalar value in the current record, if the parser is directly
+      inside a record object and the value is needed. Values nested deeper than
+      this (or outside of the "value" array) are ignored.
+    */
+    bool value(std::string&& text, bool isString){
+        if(inRecords && depth == 3 && currentColumns != nullptr){
+            projection.store(*currentColumns, record, std::move(text), isString);
+        }
+        return true;
+    }
+
+public:
+    WelshStatsSAXHandler(RecordSink& sink,
+                         const BethYw::SourceColumnMapping& cols,
+                         const StringFilterSet * const areasFilter,
+                         const StringFilterSet * const measuresFilter,
+                         const YearFilterTuple * const yearsFilter)
+        : importer(sink, cols, areasFilter, measuresFilter, yearsFilter),
+          projection(cols) {}
+
+    /*
+      Pass the records imported so far to the sink.
+    */
+    void finish(){
+        importer.finish();
+    }
+
+    bool null() override { return true; }
+    bool boolean(bool val) override { return value(val ? "true" : "false", false); }
+    bool number_integer(number_integer_t val) override { return value(std::to_string(val), false); }
+    bool number_unsigned(number_unsigned_t val) override { return value(std::to_string(val), false); }
+    bool number_float(number_float_t, const string_t& s) override { return value(std::string(s), false); }
+    bool string(string_t& val) override { return value(std::move(val), true); }
+    bool binary(binary_t&) override { return true; }
+
+    bool key(string_t& val) override {
+        currentKey = val;
+        if(inRecords && depth == 3){
+            currentColumns = projection.find(currentKey);
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        depth++;
+        if(inRecords && depth == 3){
+            record.clear();
+            importer.begin();
+            currentColumns = nullptr;
+        }
+        return true;
+    }
+
+    bool end_object() override {
+        if(inRecords && depth == 3){
+            importer.import(record);
+        }
+        depth--;
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        depth++;
+        if(depth == 2 && currentKey == "value"){
+            inRecords = true;
+        }
+        return true;
+    }
+
+    bool end_array() override {
+        if(inRecords && depth == 2){
+            inRecords = false;
+        }
+        depth--;
+        return true;
+    }
+
+    bool parse_error(std::size_t position,
+                     const std::string&,
+                     const nlohmann::detail::exception& ex) override {
+        throw std::runtime_error("Parsing error occurs at byte " +
+                                 std::to_string(position) + ": " + ex.what());
+    }
+};
+
+/*
+  This function imports the records of the "value" array of a StatsWales JSON
+  file using either a JSONScanner or a JSONIndexScanner (which share the same
+  interface). The scanner must already be inside the array.
+
+  Only the keys named in the projection are read from each record, and the
+  rest are skipped. Once the importer has every value it needs from a record
+  (e.g. as soon as the authority code of a filtered out area has been read),
+  the rest of the record is skipped.
+
+  @param scanner
+    The scanner to read the file with
+
+  @param importer
+    The WelshStatsImporter to import each record with
+
+  @param projection
+    The keys to read from each record
+
+  @return
+    void
+*/
+template <typename Scanner>
+static void scanWelshStatsRecords(Scanner& scanner,
+                                  WelshStatsImporter& importer,
+                                  const WelshStatsProjection& projection){
+    WelshStatsRecord record;
+    std::string key;
+
+    while(scanner.nextObject()){
+        record.clear();
+        importer.begin();
+        while(scanner.nextKey(key)){
+            auto columns = projection.find(key);
+            if(columns == nullptr){
+                scanner.skipValue();
+                continue;
+            }
+
+            WelshStatsField &field = record[columns->front()];
+            field.isString = scanner.readValue(field.text);
+            field.present = field.isString || field.text != "null";
+            projection.copy(*columns, record);
+
+            if(importer.complete(record)){
+                scanner.skipObject();
+                break;
+            }
+        }
+        importer.import(record);
+    }
+}
+
+/*
+  This function merges the areas imported from one chunk of a file into the
+  areas imported from the chunks before it, so that the result is the same as
+  if the chunks had been imported one after the other into the same container.
+
+  An Area or Measure that is not in areasContainer yet is moved there whole,
+  so it keeps the names and label of the first record that created it. For
+  one that is, only the values are merged, and those of the later chunk take
+  precedence.
+
+  @param areasContainer
+    The areas imported so far
+
+  @param chunk
+    The areas imported from the next chunk, which are moved from
+*/
+static void mergeAreasContainer(AreasContainer& areasContainer, AreasContainer& chunk){
+    for(auto& entry : chunk){
+        auto it = areasContainer.find(entry.first);
+        if(it == areasContainer.end()){
+            areasContainer.emplace(entry.first, std::move(entry.second));
+            continue;
+        }
+
+        Area &area = it->second;
+        for(auto& measureEntry : entry.second.measures){
+            auto measure = area.measures.find(measureEntry.first);
+            if(measure == area.measures.end()){
+                area.measures.emplace(measureEntry.first, std::move(measureEntry.second));
+                continue;
+            }
+
+            for(const auto value : measureEntry.second.getValues()){
+                measure->second.setValue(value.first, value.second);
+            }
+        }
+    }
+}
+
+/*
+  This function merges the areas imported into another Areas object, so that
+  the result is the same as if the datasets imported into it had been
+  imported into this one after the datasets already imported here. This lets
+  several datasets be imported at once, each into an Areas object of its own.
+
+  See mergeAreasContainer() for how Areas and Measures that are in both are
+  merged. Areas imported from areas.csv must be imported directly instead,
+  since populateFromAuthorityCodeCSV() replaces any Area that already exists.
+
+  @param other
+    The Areas object to merge, whose areas are moved from
+
+  @example
+    Areas data = Areas();
+    Areas dataset = Areas();
+    ... populate both ...
+    data.merge(dataset);
+*/
+void Areas::merge(Areas &other){
+    mergeAreasContainer(areasContainer, other.areasContainer);
+    other.areasContainer.clear();
+}
+
+/*
+  This function adds the areas, measures and values of a RecordBatch to this
+  Areas object, with the same result as adding each of them in turn in the
+  order they were added to the batch: areas and measures are only created if
+  they do not exist, with the first name or label they were given, and later
+  values replace earlier ones (see recordbatch.h). Each area and measure is
+  only looked up once.
+
+  All the parsers of Areas import data through a RecordBatch, which they
+  pass to an AreasSink to add it here.
+
+  @param batch
+    The batch to add
+
+  @example
+    Areas data = Areas();
+    RecordBatch batch;
+    RecordBatch::ID area = batch.addArea("W06000023", "eng", "Powys");
+    RecordBatch::ID pop = batch.addMeasure(area, "pop", "Population");
+    batch.addValue(pop, 2011, 132976);
+    data.ingest(batch);
+*/
+void Areas::ingest(const RecordBatch &batch){
+    AreasSink(areasContainer).consume(batch);
+}
+
+/*
+  This function finds where the "value" array of a StatsWales JSON document in
+  memory can be split into chunks of whole records, one for each thread.
+
+  The document is not parsed to find the boundaries: from each ideal split
+  point, the next '{' that follows a '}' and a ',' is taken to be the start of
+  a record. This is only a guess, since that sequence could also appear in a
+  string, so importWelshStatsChunks() checks that every chunk ends cleanly at
+  the start of the next one.
+
+  @param data
+    The document
+
+  @param size
+    The number of characters in the document
+
+  @param arrayStart
+    The offset of the first character after the opening '[' of the array
+
+  @param threads
+    The number of chunks to split the array into, at most
+
+  @return
+    The offset of the start of each chunk, the first being arrayStart
+*/
+static std::vector<std::size_t> splitWelshStatsRecords(const char *data,
+                                                       std::size_t size,
+                                                       std::size_t arrayStart,
+                                                       unsigned int threads){
+    auto isSpace = [](char c){
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    };
+
+    std::vector<std::size_t> starts = {arrayStart};
+    std::size_t chunkSize = std::max((size - arrayStart) / threads, MIN_JSON_CHUNK_SIZE);
+
+    for(std::size_t split = arrayStart + chunkSize; split < size; split += chunkSize){
+        std::size_t position = std::max(split, starts.back() + 1);
+        for(; position < size; position++){
+            if(data[position] != '{'){
+                continue;
+            }
+            std::size_t before = position;
+            while(before > starts.back() && isSpace(data[before - 1])){
+                before--;
+            }
+            if(before == starts.back() || data[before - 1] != ','){
+                continue;
+            }
+            before--;
+            while(before > starts.back() && isSpace(data[before - 1])){
+                before--;
+            }
+            if(before > starts.back() && data[before - 1] == '}'){
+                break;
+            }
+        }
+
+        if(position >= size){
+            break;
+        }
+        starts.push_back(position);
+        split = position;
+    }
+    return starts;
+}
+
+/*
+  This function imports a StatsWales JSON document in memory on several
+  threads. The "value" array is split into chunks of whole records, each
+  chunk is imported on its own thread into a container of its own, and the
+  containers are then passed to the sink in the order of the chunks.
+
+  @param data
+    The document
+
+  @param size
+    The number of characters in the document
+
+  @param sink
+    The sink to pass the records imported to
+
+  @param cols, areasFilter, measuresFilter, yearsFilter
+    See Areas::populateFromWelshStatsJSON()
+
+  @param threads
+    The number of threads to use
+
+  @return
+    true if the document was imported, false if it could not be split into
+    chunks of whole records (in which case nothing is passed to the sink)
+*/
+template <typename Scanner>
+static bool importWelshStatsChunks(const char *data,
+                                   std::size_t size,
+                                   RecordSink& sink,
+                                   const BethYw::SourceColumnMapping& cols,
+                                   const StringFilterSet * const areasFilter,
+                                   const StringFilterSet * const measuresFilter,
+                                   const YearFilterTuple * const yearsFilter,
+                                   unsigned int threads){
+    JSONScanner header(data, data + size);
+    if(!header.findArray("value")){
+        return true;
+    }
+
+    std::vector<std::size_t> starts = splitWelshStatsRecords(data, size, header.offset(), threads);
+    if(starts.size() < 2){
+        return false;
+    }
+    starts.push_back(size);
+
+    std::size_t chunks = starts.size() - 1;
+    std::vector<AreasContainer> partials(chunks);
+    // Not std::vector<bool>, whose elements cannot be written by several
+    // threads at once
+    std::vector<char> failed(chunks, false);
+    std::vector<std::thread> workers;
+
+    for(std::size_t i = 0; i < chunks; i++){
+        workers.emplace_back([&, i](){
+            try{
+                Scanner scanner(data + starts[i], data + starts[i + 1]);
+                AreasSink partial(partials[i]);
+                WelshStatsImporter importer(partial, cols, areasFilter, measuresFilter, yearsFilter);
+                WelshStatsProjection projection(cols);
+                scanWelshStatsRecords(scanner, importer, projection);
+                importer.finish();
+
+                // Every chunk but the last must end exactly where the next
+                // starts, otherwise the split was not between two records
+                failed[i] = i + 1 < chunks && scanner.offset() != starts[i + 1] - starts[i];
+            } catch(const std::exception&){
+                failed[i] = true;
+            }
+        });
+    }
+    for(auto& worker : workers){
+        worker.join();
+    }
+
+    if(std::find(failed.begin(), failed.end(), char(true)) != failed.end()){
+        return false;
+    }
+
+    for(const auto& partial : partials){
+        sendAreasContainer(partial, sink);
+    }
+    return true;
+}
+
+/*
+  This function imports a StatsWales JSON document in memory, using a
+  JSONScanner or JSONIndexScanner. If more than one thread is requested, and
+  the document is large enough, it is imported in chunks on several threads.
+
+  @param data
+    The document
+
+  @param size
+    The number of characters in the document
+
+  @param sink
+    The sink to pass the records imported to
+
+  @param cols, areasFilter, measuresFilter, yearsFilter
+    See Areas::populateFromWelshStatsJSON()
+
+  @param threads
+    The number of threads to use
+
+  @throws
+    std::runtime_error if a parsing error occurs (e.g. due to a malformed file)
+    std::out_of_range if there are not enough columns in cols
+*/
+template <typename Scanner>
+static void importWelshStatsDocument(const char *data,
+                                     std::size_t size,
+                                     RecordSink& sink,
+                                     const BethYw::SourceColumnMapping& cols,
+                                     const StringFilterSet * const areasFilter,
+                                     const StringFilterSet * const measuresFilter,
+                                     const YearFilterTuple * const yearsFilter,
+                                     unsigned int threads){
+    if(threads > 1 && size >= 2 * MIN_JSON_CHUNK_SIZE &&
+       importWelshStatsChunks<Scanner>(data, size, sink, cols, areasFilter,
+                                       measuresFilter, yearsFilter, threads)){
+        return;
+    }
+
+    // Any error that made importing the chunks fail is found (and thrown)
+    // again here
+    Scanner scanner(data, data + size);
+    WelshStatsImporter importer(sink, cols, areasFilter, measuresFilter, yearsFilter);
+    WelshStatsProjection projection(cols);
+    if(scanner.findArray("value")){
+        scanWelshStatsRecords(scanner, importer, projection);
+    }
+    importer.finish();
+}
+
+/*
+  This function imports some of the records of a StatsWales JSON document in
+  memory, using a JSONScanner or JSONIndexScanner to read each of them.
+
+  @param data
+    The document
+
+  @param ranges
+    The byte range of each record to import, in order (see RecordIndex)
+
+  @param sink
+    The sink to pass the records imported to
+
+  @param cols, areasFilter, measuresFilter, yearsFilter
+    See Areas::populateFromWelshStatsJSON()
+
+  @throws
+    std::runtime_error if a parsing error occurs (e.g. due to a malformed file)
+    std::out_of_range if there are not enough columns in cols
+*/
+template <typename Scanner>
+static void importWelshStatsRecords(const char *data,
+                                    const std::vector<RecordIndex::Range>& ranges,
+                                    RecordSink& sink,
+                                    const BethYw::SourceColumnMapping& cols,
+                                    const StringFilterSet * const areasFilter,
+                                    const StringFilterSet * const measuresFilter,
+                                    const YearFilterTuple * const yearsFilter){
+    WelshStatsImporter importer(sink, cols, areasFilter, measuresFilter, yearsFilter);
+    WelshStatsProjection projection(cols);
+    for(const RecordIndex::Range& range : ranges){
+        Scanner scanner(data + range.first, data + range.second);
+        scanWelshStatsRecords(scanner, importer, projection);
+    }
+    importer.finish();
+}
+
+/*
+  This function imports a StatsWales JSON file into this Areas object. See
+  the overload below, which passes its records to any RecordSink.
+*/
+void Areas::populateFromWelshStatsJSON(std::istream& is,
+                                       const BethYw::SourceColumnMapping& cols,
+                                       const StringFilterSet * const areasFilter,
+                                       const StringFilterSet * const measuresFilter,
+                                       const YearFilterTuple * const yearsFilter,
+                                       const RecordIndex * const index){
+    AreasSink sink(areasContainer);
+    populateFromWelshStatsJSON(is, cols, sink, areasFilter, measuresFilter, yearsFilter, index);
 }
 
 /*
@@ -214,14 +1412,32 @@ void Areas::populateFromAuthorityCodeCSV(
   code, English name (the files only contain the English names), and each measure by
   year.
 
-  If there are an Area object that does not exist in the Areas container, a
-  new area object would be created
+  The records are passed to a RecordSink in batches. If there are an Area
+  object that does not exist in the sink (e.g. the Areas container, for an
+  AreasSink), a new area object would be created
 
   If areasFilter is a non-empty set only include areas matching the filter. If
   measuresFilter is a non-empty set only include measures matching the filter.
   If yearsFilter is not equal to <0,0>, only import years within the range
   specified by the tuple (inclusive).
 
+  The document is read using the backend set by setJSONBackend(). By default
+  (JSONBackend::Scan) records are streamed through a JSONScanner, which only
+  decodes the keys named in cols. JSONBackend::SIMD reads the document into
+  memory and walks it with a JSONIndexScanner instead. JSONBackend::SAX
+  streams records through the nlohmann JSON library, while JSONBackend::DOM
+  parses the whole document into memory with it first.
+
+  If more than one thread has been set with setThreads(), the Scan and SIMD
+  backends read the document into memory, split its "value" array into
+  chunks of whole records, and import the chunks in parallel. The result is
+  the same as importing the records in order on one thread.
+
+  If the stream reads from a MemoryBuffer (e.g. an InputMappedFile), the Scan
+  and SIMD backends read the document in place, without copying it. If an
+  index of the document's records is also given, they only read the records
+  that the filters need (see RecordIndex::select()).
+
   @param is
     The input stream from InputSource
 
@@ -229,6 +1445,9 @@ void Areas::populateFromAuthorityCodeCSV(
     A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
     that give the column header in the CSV file
 
+  @param sink
+    The sink to pass the areas, measures and values read to, in batches
+
   @param areasFilter
     An umodifiable pointer to set of umodifiable strings of areas to import,
     or an empty set if all areas should be imported
@@ -242,6 +1461,10 @@ void Areas::populateFromAuthorityCodeCSV(
     where if both values are 0, then all years should be imported, otherwise
     they should be treated as the range of years to be imported (inclusively)
 
+  @param index
+    An index of the records of the document the stream reads, or nullptr to
+    read every record
+
   @return
     void
 
@@ -251,174 +1474,110 @@ void Areas::populateFromAuthorityCodeCSV(
 */
 void Areas::populateFromWelshStatsJSON(std::istream& is,
                                        const BethYw::SourceColumnMapping& cols,
+                                       RecordSink& sink,
                                        const StringFilterSet * const areasFilter,
                                        const StringFilterSet * const measuresFilter,
-                                       const YearFilterTuple * const yearsFilter){
-
-    json j;
-    is >> j;
-
-    // Loop through every line of the Json file
-    for (auto& el : j["value"].items()) {
-        auto &data = el.value();
-
-        // Getting the local Authority Code
-        std::string localAuthorityCode = data[cols.at(BethYw::SourceColumn::AUTH_CODE)];
-
-        // Boolean to check if the line read is the data we need from the areasFilter
-        bool isInArea = false;
-
-        /* If areasFilter is empty or if the current area is
-         * in the areasFilter, we set isInArea to true and
-         * if the data is not currently in our areasContainer,
-         * we set the local authority code and name of the area object.
-         *
-         * Otherwise, we do nothing.
-         *
-        */
-        if(areasFilter->empty()){
-            isInArea = true;
-            if(areasContainer.find(localAuthorityCode) == areasContainer.end()){
-                areasContainer[localAuthorityCode].setLocalAuthorityCode(localAuthorityCode);
-                areasContainer[localAuthorityCode].setName("eng", data[cols.at(BethYw::SourceColumn::AUTH_NAME_ENG)]);
-            }
+                                       const YearFilterTuple * const yearsFilter,
+                                       const RecordIndex * const index){
+
+    // Imports a document in memory with the Scan or SIMD backend
+    auto importDocument = [&](const char *data, std::size_t size){
+        if(jsonBackend == JSONBackend::SIMD){
+            importWelshStatsDocument<JSONIndexScanner>(data, size, sink, cols, areasFilter,
+                                                       measuresFilter, yearsFilter, threads);
         } else {
-            if(areasFilter->find(localAuthorityCode) != areasFilter->end()){
-                isInArea = true;
-                if(areasContainer.find(localAuthorityCode) == areasContainer.end()){
-                    areasContainer[localAuthorityCode].setLocalAuthorityCode(localAuthorityCode);
-                    areasContainer[localAuthorityCode].setName("eng", data[cols.at(BethYw::SourceColumn::AUTH_NAME_ENG)]);
+            importWelshStatsDocument<JSONScanner>(data, size, sink, cols, areasFilter,
+                                                  measuresFilter, yearsFilter, threads);
+        }
+    };
+
+    if(jsonBackend == JSONBackend::DOM){
+        json j;
+        is >> j;
+
+        WelshStatsImporter importer(sink, cols, areasFilter, measuresFilter, yearsFilter);
+        WelshStatsProjection projection(cols);
+        WelshStatsRecord record;
+
+        // Loop through every line of the Json file
+        for (auto& el : j["value"].items()) {
+            record.clear();
+            importer.begin();
+            for (auto& member : el.value().items()) {
+                auto columns = projection.find(member.key());
+                if(columns != nullptr && !member.value().is_null()){
+                    bool isString = member.value().is_string();
+                    projection.store(*columns, record,
+                                     isString ? member.value().get<std::string>() : member.value().dump(),
+                                     isString);
                 }
             }
+            importer.import(record);
         }
-
-
-        std::string measureCode = "";
-        /*
-         * Since some datasets does not have MEASURE_CODE in the JSON file,
-         * we replace it with SINGLE_MEASURE_CODE that was set in the datasets.h
-         */
-        if(cols.find(BethYw::SourceColumn::MEASURE_CODE) == cols.end()){
-            measureCode = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_CODE);
-        } else {
-            if(data[cols.at(BethYw::SourceColumn::MEASURE_CODE)].empty()){
-                throw std::out_of_range("There are not enough columns in cols");
+        importer.finish();
+    } else if(jsonBackend == JSONBackend::SAX){
+        WelshStatsSAXHandler handler(sink, cols,
+                                     areasFilter, measuresFilter, yearsFilter);
+        json::sax_parse(is, &handler);
+        handler.finish();
+    } else if(dynamic_cast<MemoryBuffer *>(is.rdbuf()) != nullptr){
+        // The document is already in memory (e.g. a memory-mapped file), so
+        // it is read in place
+        MemoryBuffer *memory = static_cast<MemoryBuffer *>(is.rdbuf());
+        if(index != nullptr && memory->available() == index->getSize()){
+            std::vector<RecordIndex::Range> ranges = index->select(areasFilter, measuresFilter);
+            if(jsonBackend == JSONBackend::SIMD){
+                importWelshStatsRecords<JSONIndexScanner>(memory->data(), ranges, sink, cols,
+                                                          areasFilter, measuresFilter, yearsFilter);
             } else {
-                measureCode = data[cols.at(BethYw::SourceColumn::MEASURE_CODE)];
+                importWelshStatsRecords<JSONScanner>(memory->data(), ranges, sink, cols,
+                                                     areasFilter, measuresFilter, yearsFilter);
             }
+        } else {
+            importDocument(memory->data(), memory->available());
         }
-        // Convert the measure code to lowercase
-        std::transform(measureCode.begin(), measureCode.end(), measureCode.begin(), ::tolower);
-
-        // Boolean to check if the line read is part of the measuresFilter
-        bool isInMeasures = false;
-
-        // We read measures data only if it is in our areasFilter
-        if(isInArea){
-            /* If measuresFilter is empty or if the current measure is
-            * in the measuresFilter, we set isInMeasures to true and
-            * if the data is not currently in our area object,
-            * we create a new Measure object and add it to the current
-             * area object.
-            *
-            * Otherwise, we do nothing.
-            *
-            */
-            if(measuresFilter->empty()){
-                //std::cout << "I shouldnt end up here" << "\n";
-                isInMeasures = true;
-                if(areasContainer[localAuthorityCode].measures.find(measureCode) == areasContainer[localAuthorityCode].measures.end()){
-                    std::string label = "";
-                    /*
-                    * Since some datasets does not have MEASURE_NAME in the JSON file,
-                    * we replace it with SINGLE_MEASURE_NAME that was set in the datasets.h
-                    */
-                    if(cols.find(BethYw::SourceColumn::MEASURE_NAME) == cols.end()){
-                        label = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_NAME);
-                    } else {
-                        if(data[cols.at(BethYw::SourceColumn::MEASURE_NAME)].empty()){
-                            throw std::out_of_range("There are not enough columns in cols");
-                        } else {
-                            label = data[cols.at(BethYw::SourceColumn::MEASURE_NAME)];
-                        }
-                    }
-                    //std::string label = data[cols.at(BethYw::SourceColumn::MEASURE_NAME)];
-                    Measure *measure = new Measure(measureCode, label);
-                    areasContainer[localAuthorityCode].setMeasure(measureCode, *measure);
-                }
-            } else {
-                if(measuresFilter->find(measureCode) != measuresFilter->end()) {
-                    isInMeasures = true;
-                    if (areasContainer[localAuthorityCode].measures.find(measureCode) == areasContainer[localAuthorityCode].measures.end()) {
-                        std::string label;
-                        /*
-                        * Since some datasets does not have MEASURE_NAME in the JSON file,
-                        * we replace it with SINGLE_MEASURE_NAME that was set in the datasets.h
-                        */
-                        if(cols.find(BethYw::SourceColumn::MEASURE_NAME) == cols.end()){
-                            label = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_NAME);
-                        } else {
-                            if(data[cols.at(BethYw::SourceColumn::MEASURE_NAME)].empty()){
-                                throw std::out_of_range("There are not enough columns in cols");
-                            } else {
-                                label = data[cols.at(BethYw::SourceColumn::MEASURE_NAME)];
-                            }
-                        }
-                        Measure *measure = new Measure(measureCode, label);
-                        areasContainer[localAuthorityCode].setMeasure(measureCode, *measure);
-                    }
-                }
-            }
+        memory->consume(memory->available());
+    } else if(jsonBackend == JSONBackend::Scan && threads <= 1){
+        JSONScanner scanner(is);
+        WelshStatsImporter importer(sink, cols, areasFilter, measuresFilter, yearsFilter);
+        WelshStatsProjection projection(cols);
+        if(scanner.findArray("value")){
+            scanWelshStatsRecords(scanner, importer, projection);
         }
-
-        /*
-         * If isInMeasures and isInArea is true,
-         * We start reading the year data
-         */
-        if(isInMeasures && isInArea){
-            std::string yearInString = data[cols.at(BethYw::SourceColumn::YEAR)];
-            int year = std::stoi(yearInString);
-            int minYear = 0;
-            int maxYear = 0;
-            std::tie(minYear, maxYear) = *yearsFilter;
-            /*
-             * If year is within the yearFilter time frame and if the yearFilter is <0,0>,
-             * we save the data to our measure object
-             */
-            if((year >= minYear && year <= maxYear) || (minYear == 0 && maxYear == 0)){
-                //std::cout << "LocalAuthorityCode: " << localAuthorityCode << "\n";
-                //std::cout << "MeasureCode: " << measureCode << "\n";
-                //std::cout << "Value: " << data[cols.at(BethYw::SourceColumn::VALUE)] << "\n";
-
-                /*
-                if(typeof(data[cols.at(BethYw::SourceColumn::VALUE)].value()).name()){
-
-                }
-                 */
-                double measureValue;
-                std::string stringCompare = "string";
-
-                if(stringCompare.compare(data[cols.at(BethYw::SourceColumn::VALUE)].type_name()) == 0){
-                    std::string dataInString = data[cols.at(BethYw::SourceColumn::VALUE)];
-
-                    measureValue = std::stod(dataInString);
-                } else {
-                    measureValue = data[cols.at(BethYw::SourceColumn::VALUE)];
-                }
-
-                areasContainer[localAuthorityCode].getMeasure(measureCode).setValue(year, measureValue);
-
-                //std::cout << "Result: " << areasContainer[localAuthorityCode].getMeasure(measureCode)<< "\n\n";
-            }
+        importer.finish();
+    } else {
+        // The structural index is built over the whole document, and the
+        // document must be split into chunks to be read on several threads,
+        // so it is read into memory first
+        std::string document;
+        char block[65536];
+        while(is.read(block, sizeof(block)), is.gcount() > 0){
+            document.append(block, is.gcount());
         }
+        importDocument(document.data(), document.size());
     }
 }
 
+/*
+  This function imports a CSV file that contains a single measure into this
+  Areas object. See the overload below, which passes its values to any
+  RecordSink.
+*/
+void Areas::populateFromAuthorityByYearCSV(std::istream& is,
+                                       const BethYw::SourceColumnMapping& cols,
+                                       const StringFilterSet * const areasFilter,
+                                       const StringFilterSet * const measuresFilter,
+                                       const YearFilterTuple * const yearsFilter){
+    AreasSink sink(areasContainer);
+    populateFromAuthorityByYearCSV(is, cols, sink, areasFilter, measuresFilter, yearsFilter);
+}
+
 /*
   This function imports CSV files that contain a single measure. The 
   CSV file consists of columns containing the authority code and years.
   Each row contains an authority code and values for each year (or no value
-  if the data doesn't exist).
+  if the data doesn't exist). The values are passed to a RecordSink in
+  batches.
 
   @param is
     The input stream from InputSource
@@ -427,6 +1586,9 @@ void Areas::populateFromWelshStatsJSON(std::istream& is,
     A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
     that give the column header in the CSV file
 
+  @param sink
+    The sink to pass the areas, measures and values read to, in batches
+
   @param areasFilter
     An umodifiable pointer to set of umodifiable strings for areas to import,
     or an empty set if all areas should be imported
@@ -451,111 +1613,130 @@ void Areas::populateFromWelshStatsJSON(std::istream& is,
 
   @throws 
     std::runtime_error if a parsing error occurs (e.g. due to a malformed file)
-    std::out_of_range if there are not enough columns in cols
+    std::out_of_range if there are not enough columns in cols, or a row has
+    more values than there are years
 */
 void Areas::populateFromAuthorityByYearCSV(std::istream& is,
                                        const BethYw::SourceColumnMapping& cols,
+                                       RecordSink& sink,
                                        const StringFilterSet * const areasFilter,
                                        const StringFilterSet * const measuresFilter,
                                        const YearFilterTuple * const yearsFilter){
 
-    // Getting the first line of the csv file which is the heading: Authority code + year
-    std::string str;
-    std::getline(is, str);
+    // Getting the first row of the csv file which is the heading: Authority code + year
+    CSVScanner scanner(is);
     std::vector<std::string> headings;
-    std::stringstream stream(str);
-    while(stream.good()){
-        std::string substr;
-        getline(stream, substr, ',');
-        headings.push_back(substr);
+    if(scanner.nextRow()){
+        for(unsigned int i = 0; i < scanner.size(); i++){
+            headings.push_back(scanner[i].str());
+        }
     }
 
     // Getting the year value from yearsFilter
     int minYear = 0;
     int maxYear = 0;
-    std::tie(minYear, maxYear) = *yearsFilter;
-
-    // Reading data from every line
-    while(is.good()){
-        std::getline(is, str);
+    if(yearsFilter != nullptr){
+        std::tie(minYear, maxYear) = *yearsFilter;
+    }
 
-        // Vector for storing all values from the line
-        std::vector<std::string> values;      // Index: 0 = area code, numbers after 0 correspond to year
-        std::stringstream ss(str);
+    if(cols.at(BethYw::SourceColumn::SINGLE_MEASURE_CODE).empty()){
+        throw std::out_of_range("There are not enough columns in cols");
+    }
+    // We get the data base on SINGLE_MEASURE_CODE and convert it to lowercase
+    std::string measureCode = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_CODE);
+    std::transform(measureCode.begin(), measureCode.end(), measureCode.begin(), ::tolower);
+    // Getting the name of the label from SINGLE_MEASURE_NAME
+    std::string measureLabel = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_NAME);
+
+    /*
+     * The whole file is a single measure, so if it is not part of the
+     * measuresFilter, none of the file needs to be read
+     */
+    if(measuresFilter != nullptr && !measuresFilter->empty() &&
+       measuresFilter->find(measureCode) == measuresFilter->end()){
+        return;
+    }
 
-        //Split the line into values vector
-        while(ss.good()){
-            std::string substr;
-            getline(ss, substr, ',');
-            values.push_back(substr);
+    /*
+     * The heading is compiled once into a plan of the columns to import: the
+     * year of each column is decoded, and the columns whose year is not in
+     * the yearsFilter are left out, so that each row only decodes the cells
+     * that are imported
+     */
+    struct YearColumn {
+        unsigned int index;
+        int year;
+    };
+    std::vector<YearColumn> plan;
+    for(unsigned int i = 1; i < headings.size(); i++){
+        int year;
+        if(!BethYw::decodeInt(headings.at(i), year)){
+            throw std::runtime_error("Invalid year: " + headings.at(i));
         }
+        if((year >= minYear && year <= maxYear) || (minYear == 0 && maxYear == 0)){
+            plan.push_back(YearColumn{i, year});
+        }
+    }
 
-        std::string localAuthorityCode = values[0];
+    // If no year is imported, none of the rest of the file needs to be read
+    if(plan.empty()){
+        return;
+    }
 
-        /* Check if the area is in the areasFilter
-         * If yes, we add data to the area object
-         */
-        if(areasFilter != NULL && areasFilter->find(localAuthorityCode) == areasFilter->end() && !areasFilter->empty()){
-            continue;
-        } else {
-            // Starting from index 1 because we have the area code already
-            for(unsigned int i = 1; i < values.size(); i++){
-                int year = std::stoi(headings.at(i));
-                //std::cout << "Year: " << year << "\n";
-                //std::cout << "MinYear: " << minYear << "\n";
-                //std::cout << "MaxYear: " << maxYear << "\n\n";
-                if((year >= minYear && year <= maxYear) || (minYear == 0 && maxYear == 0)){
-                    if(cols.at(BethYw::SourceColumn::SINGLE_MEASURE_CODE).empty()){
-                        throw std::out_of_range("There are not enough columns in cols");
-                    } else {
-                        // We get the data base on SINGLE_MEASURE_CODE and convert it to lowercase
-                        std::string measureCode = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_CODE);
-                        std::transform(measureCode.begin(), measureCode.end(), measureCode.begin(), ::tolower);
-                        // Getting the name of the label from SINGLE_MEASURE_NAME
-                        std::string measureLabel = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_NAME);
-                        /*
-                         * If the current measureCode is part in the measureFilter or if the
-                         * measureFilter is empty, we add the data to the measure object
-                         */
-                        if(measuresFilter->find(measureCode) != measuresFilter->end() || measuresFilter->empty()){
-                            /*
-                             * If the measure object is not created before,
-                             * we create a new measure object and add it
-                             * to the area object
-                             */
-                            if(areasContainer[localAuthorityCode].measures.find(measureCode) != areasContainer[localAuthorityCode].measures.end()){
-                                double measureValue = std::stod(values.at(i));
-                                // Adding value to the Measure object
-                                areasContainer[localAuthorityCode].getMeasure(measureCode).setValue(year, measureValue);
-                            } else {
-                                double measureValue = std::stod(values.at(i));
-                                Measure *measure = new Measure(measureCode, measureLabel);
-                                measure->setValue(year, measureValue);
-                                areasContainer[localAuthorityCode].setMeasure(measureCode, *measure);
-                            }
-                        }
-                    }
-                }
+    // Reading data from every row. The values are added in batches, and
+    // those read before a malformed row or value are still added
+    RecordBatch batch;
+    std::string localAuthorityCode;
+    try{
+        while(scanner.nextRow()){
+            /* Check if the area code in the first column is in the areasFilter
+             * If not, we ignore the row without decoding the rest of it
+             */
+            localAuthorityCode.assign(scanner[0].begin(), scanner[0].end());
+            if(areasFilter != NULL && areasFilter->find(localAuthorityCode) == areasFilter->end() && !areasFilter->empty()){
+                continue;
+            }
+
+            // Index: 0 = area code, numbers after 0 correspond to year
+            if(scanner.size() > headings.size()){
+                throw std::out_of_range("There are more values than years for " + localAuthorityCode);
             }
+
             /*
-            for(auto it = std::next(values.begin()); it != values.end(); it++){
-                int value = std::stoi(*it);
-                if(year >= minYear && year <= maxYear){
-                    if(cols.at(BethYw::SourceColumn::SINGLE_MEASURE_CODE).empty()){
-                        throw std::out_of_range("There are not enough columns in cols");
-                    } else {
-                        // We get the data base on SINGLE_MEASURE_CODE
-                        std::string measureCode = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_CODE);
-                        double measureValue = std::stod(*it);
-                        // Adding value to the Measure object
-                        areasContainer[localAuthorityCode].getMeasure(measureCode).setValue(year, measureValue);
-                    }
+             * The measure is found (or created and added to the area object) for
+             * the first value imported from the row, and every later value of the
+             * row is added to it directly
+             */
+            RecordBatch::ID measure = NOT_BATCHED;
+            for(const YearColumn &column : plan){
+                if(column.index >= scanner.size()){
+                    break;
+                }
+
+                const CSVField &field = scanner[column.index];
+                double measureValue;
+                if(!BethYw::decodeDouble(field.begin(), field.end(), measureValue)){
+                    throw std::runtime_error("Invalid value: " + field.str());
                 }
+
+                if(measure == NOT_BATCHED){
+                    measure = batch.addMeasure(batch.addArea(localAuthorityCode), measureCode, measureLabel);
+                }
+
+                // Adding value to the Measure object
+                batch.addValue(measure, column.year, measureValue);
+            }
+
+            if(batch.full()){
+                sink.consume(batch);
+                batch.clear();
             }
-             */
         }
+    } catch(const std::exception&){
+        sink.consume(batch);
+        throw;
     }
-
+    sink.consume(batch);
 }
 
 /*
@@ -605,14 +1786,71 @@ void Areas::populate(
     const BethYw::SourceColumnMapping &cols,
     const StringFilterSet * const areasFilter,
     const StringFilterSet * const measuresFilter,
+    const YearFilterTuple * const yearsFilter)
+     {
+    AreasSink sink(areasContainer);
+    populate(is, type, cols, sink, areasFilter, measuresFilter, yearsFilter);
+}
+
+/*
+  Parse data from an standard input stream, that is of a particular type,
+  and with a given column mapping, filtering for specific areas, measures,
+  and years, and pass it to a RecordSink in batches instead of filling the
+  container. This lets the data be used (e.g. summarised or written out)
+  without being stored in an Areas object at all.
+
+  @param is
+    The input stream from InputSource
+
+  @param type
+    A value from the BethYw::SourceDataType enum which states the underlying
+    data file structure
+
+  @param cols
+    A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
+    that give the column header in the CSV file
+
+  @param sink
+    The sink to pass the areas, measures and values read to, in batches
+
+  @param areasFilter, measuresFilter, yearsFilter
+    See the overload above
+
+  @return
+    void
+
+  @throws 
+    std::runtime_error if a parsing error occurs (e.g. due to a malformed file),
+    the stream is not open/valid/has any contents, or an unexpected type
+    is passed in.
+    std::out_of_range if there are not enough columns in cols
+
+  @example
+    class CountingSink : public RecordSink {
+    public:
+      std::size_t values = 0;
+      void consume(const RecordBatch &batch) override { values += batch.size(); }
+    };
+
+    Areas data = Areas();
+    CountingSink sink;
+    data.populate(is, BethYw::WelshStatsJSON, cols, sink);
+*/
+void Areas::populate(
+    std::istream &is,
+    const BethYw::SourceDataType &type,
+    const BethYw::SourceColumnMapping &cols,
+    RecordSink &sink,
+    const StringFilterSet * const areasFilter,
+    const StringFilterSet * const measuresFilter,
     const YearFilterTuple * const yearsFilter)
      {
     if (type == BethYw::AuthorityCodeCSV) {
-        populateFromAuthorityCodeCSV(is, cols, areasFilter);
+        populateFromAuthorityCodeCSV(is, cols, sink, areasFilter);
     } else if(type == BethYw::WelshStatsJSON){
-        populateFromWelshStatsJSON(is, cols, areasFilter, measuresFilter, yearsFilter);
+        populateFromWelshStatsJSON(is, cols, sink, areasFilter, measuresFilter, yearsFilter);
     } else if(type == BethYw::AuthorityByYearCSV){
-        populateFromAuthorityByYearCSV(is, cols, areasFilter, measuresFilter, yearsFilter);
+        populateFromAuthorityByYearCSV(is, cols, sink, areasFilter, measuresFilter, yearsFilter);
     } else {
         throw std::runtime_error("Areas::populate: Unexpected data type");
     }
@@ -669,10 +1907,9 @@ std::string Areas::toJSON() const {
         for(auto it = areasContainer.begin(); it != areasContainer.end(); it++){
             // Print out all the measures we have in this area object
             for(auto jt = it->second.measures.begin(); jt != it->second.measures.end(); jt++){
-                std::map<int, double> list = jt->second.getAllValue();
                 // Print out all the values we have in this measure object
-                for(auto zt = list.begin(); zt != list.end(); zt++){
-                    j[it->first]["measures"][jt->second.getCodename()][std::to_string(zt->first)] = zt->second;
+                for(auto value : jt->second.getValues()){
+                    j[it->first]["measures"][jt->second.getCodename()][std::to_string(value.first)] = value.second;
                 }
             }
             // Printing out all the names in this area object
@@ -33,6 +33,7 @@
 
 #include "datasets.h"
 #include "area.h"
+#include "recordbatch.h"
 
 /*
   An alias for filters based on strings such as categorisations e.g. area,
@@ -53,6 +54,41 @@ using YearFilterTuple = std::tuple<unsigned int, unsigned int>;
 */
 using AreasContainer = std::map<std::string, Area>;
 
+class RecordIndex;
+
+/*
+  A RecordSink that adds each batch of records it is given to an
+  AreasContainer, which is how the parsers of Areas fill an Areas object.
+*/
+class AreasSink : public RecordSink {
+private:
+  AreasContainer &areasContainer;
+
+public:
+  explicit AreasSink(AreasContainer &areasContainer);
+
+  void consume(const RecordBatch &batch) override;
+  bool contains(const std::string &code) const override;
+  bool contains(const std::string &code, const std::string &codename) const override;
+};
+
+/*
+  The backends Areas can use to read a StatsWales JSON file. DOM parses the
+  whole document into memory before importing any data, whereas SAX streams
+  the document and imports each record of the "value" array as soon as it has
+  been read, so memory use does not grow with the size of the file. Scan also
+  streams records, but uses a JSONScanner to decode only the keys of each
+  record that are named in the dataset's SourceColumnMapping. SIMD reads the
+  same keys using a JSONIndexScanner, which builds a structural index of the
+  whole document with SIMD instructions before walking its records.
+*/
+enum class JSONBackend {
+  DOM,
+  SAX,
+  Scan,
+  SIMD
+};
+
 /*
   Areas is a class that stores all the data categorised by area. The 
   underlying Standard Library container is customisable using the alias above.
@@ -70,9 +106,17 @@ using AreasContainer = std::map<std::string, Area>;
 class Areas {
 private:
     AreasContainer areasContainer;
+    JSONBackend jsonBackend = JSONBackend::Scan;
+    unsigned int threads = 1;
 
 public:
   Areas();
+
+  void setJSONBackend(JSONBackend backend);
+  JSONBackend getJSONBackend() const;
+
+  void setThreads(unsigned int threads);
+  unsigned int getThreads() const;
   
   void populateFromAuthorityCodeCSV(
       std::istream& is,
@@ -80,8 +124,22 @@ public:
       const StringFilterSet * const areas = nullptr)
       noexcept(false);
 
+  void populateFromAuthorityCodeCSV(
+      std::istream& is,
+      const BethYw::SourceColumnMapping& cols,
+      RecordSink& sink,
+      const StringFilterSet * const areas = nullptr)
+      noexcept(false);
+
+  void populateFromAuthorityByYearCSV(std::istream& is,
+                                      const BethYw::SourceColumnMapping& cols,
+                                      const StringFilterSet * const areasFilter,
+                                      const StringFilterSet * const measuresFilter,
+                                      const YearFilterTuple * const yearsFilter);
+
   void populateFromAuthorityByYearCSV(std::istream& is,
                                       const BethYw::SourceColumnMapping& cols,
+                                      RecordSink& sink,
                                       const StringFilterSet * const areasFilter,
                                       const StringFilterSet * const measuresFilter,
                                       const YearFilterTuple * const yearsFilter);
@@ -101,15 +159,39 @@ public:
       const YearFilterTuple * const yearsFilter = nullptr)
       noexcept(false);
 
+  void populate(
+      std::istream& is,
+      const BethYw::SourceDataType& type,
+      const BethYw::SourceColumnMapping& cols,
+      RecordSink& sink,
+      const StringFilterSet * const areasFilter = nullptr,
+      const StringFilterSet * const measuresFilter = nullptr,
+      const YearFilterTuple * const yearsFilter = nullptr)
+      noexcept(false);
+
   void populateFromWelshStatsJSON(std::istream& is,
                                   const BethYw::SourceColumnMapping& cols,
                                   const StringFilterSet * const areasFilter,
                                   const StringFilterSet * const measuresFilter,
-                                  const YearFilterTuple * const yearsFilter);
+                                  const YearFilterTuple * const yearsFilter,
+                                  const RecordIndex * const index = nullptr);
 
-  void setArea(std::string localAuthorityCode, Area &area);
+  void populateFromWelshStatsJSON(std::istream& is,
+                                  const BethYw::SourceColumnMapping& cols,
+                                  RecordSink& sink,
+                                  const StringFilterSet * const areasFilter,
+                                  const StringFilterSet * const measuresFilter,
+                                  const YearFilterTuple * const yearsFilter,
+                                  const RecordIndex * const index = nullptr);
+
+  void setArea(std::string localAuthorityCode, const Area &area);
+  void setArea(std::string localAuthorityCode, Area &&area);
+  Area& emplaceArea(const std::string &localAuthorityCode);
+  void merge(Areas &other);
+  void ingest(const RecordBatch &batch);
   Area& getArea(std::string localAuthorityCode);
   AreasContainer& getAreaContainer();
+  const AreasContainer& getAreaContainer() const;
   unsigned int size() const;
 
   std::string toJSON() const;
@@ -0,0 +1,130 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the implementation of the AuthorityCodes class. See the
+  header file for how codes are interned and filtered.
+*/
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "authoritycodes.h"
+
+/*
+  Construct a table of authority codes, interning the codes of an area filter.
+
+  The filter's codes are interned in sorted order, so that the IDs they are
+  given do not depend on the order of the StringFilterSet.
+
+  @param areasFilter
+    An umodifiable pointer to set of umodifiable strings for areas to import,
+    or an empty set (or nullptr) if all areas should be imported
+
+  @example
+    StringFilterSet areasFilter{"W06000011", "W06000024"};
+    AuthorityCodes codes(&areasFilter);
+    bool swansea = codes.accepted(codes.intern("W06000011"));
+*/
+AuthorityCodes::AuthorityCodes(const StringFilterSet * const areasFilter) : filtered(0){
+    if(areasFilter == nullptr || areasFilter->empty()){
+        return;
+    }
+
+    std::vector<std::string> sorted(areasFilter->begin(), areasFilter->end());
+    std::sort(sorted.begin(), sorted.end());
+    for(const auto &code : sorted){
+        intern(code);
+    }
+    filtered = size();
+}
+
+/*
+  This function gets the ID of an authority code, giving it the next unused
+  ID if it has not been seen before.
+
+  @param code
+    The authority code
+
+  @return
+    The ID of the code
+*/
+AuthorityCodes::ID AuthorityCodes::intern(const std::string &code){
+    auto it = ids.find(code);
+    if(it != ids.end()){
+        return it->second;
+    }
+
+    it = ids.emplace(code, size()).first;
+    codes.push_back(&it->first);
+    return it->second;
+}
+
+/*
+  This function gets the ID of an authority code, if it has been interned.
+
+  @param code
+    The authority code
+
+  @param id
+    Set to the ID of the code, if it has one
+
+  @return
+    true if the code has been interned, false otherwise
+*/
+bool AuthorityCodes::find(const std::string &code, ID &id) const{
+    auto it = ids.find(code);
+    if(it == ids.end()){
+        return false;
+    }
+    id = it->second;
+    return true;
+}
+
+/*
+  This function gets the authority code of an ID.
+
+  @param id
+    The ID of the code
+
+  @return
+    The authority code
+
+  @throws
+    std::out_of_range if no code has the ID
+*/
+const std::string &AuthorityCodes::code(ID id) const{
+    return *codes.at(id);
+}
+
+/*
+  This function tests whether the code of an ID passes the area filter.
+
+  @param id
+    The ID of the code
+
+  @return
+    true if the filter was empty or contains the code, false otherwise
+*/
+bool AuthorityCodes::accepted(ID id) const{
+    return filtered == 0 || id < filtered;
+}
+
+/*
+  This function gets the number of codes that have been interned, which is
+  also the next ID that will be given out.
+
+  @return
+    The number of codes
+*/
+AuthorityCodes::ID AuthorityCodes::size() const{
+    return static_cast<ID>(codes.size());
+}
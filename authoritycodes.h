@@ -0,0 +1,54 @@
+#ifndef AUTHORITYCODES_H_
+#define AUTHORITYCODES_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the declaration of the AuthorityCodes class, which
+  interns the local authority codes read whilst importing a file as dense
+  integer IDs (0, 1, 2, ...), so that anything the importer needs to know
+  about an area can be kept in an array indexed by its ID, rather than looked
+  up by its code again for every record.
+
+  The codes of the area filter are interned first, so a code passes the
+  filter exactly when its ID is below the number of codes in the filter, and
+  testing it is a single comparison. Codes are only turned back into strings
+  when they are needed as a key of an AreasContainer.
+ */
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "areas.h"
+
+class AuthorityCodes {
+public:
+  using ID = std::uint32_t;
+
+private:
+  std::unordered_map<std::string, ID> ids;
+
+  // The code of each ID, which points into the key of ids
+  std::vector<const std::string *> codes;
+
+  // The number of codes in the area filter, or 0 if every area passes it
+  ID filtered;
+
+public:
+  AuthorityCodes(const StringFilterSet * const areasFilter = nullptr);
+
+  ID intern(const std::string &code);
+  bool find(const std::string &code, ID &id) const;
+
+  const std::string &code(ID id) const;
+  bool accepted(ID id) const;
+  ID size() const;
+};
+
+#endif // AUTHORITYCODES_H_
@@ -22,8 +22,13 @@
   additional functions not specified.
 */
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_set>
 #include <vector>
@@ -33,7 +38,10 @@
 #include "areas.h"
 #include "datasets.h"
 #include "bethyw.h"
+#include "catalog.h"
 #include "input.h"
+#include "recordindex.h"
+#include "registry.h"
 
 /*
   Run Beth Yw?, parsing the command line arguments, importing the data,
@@ -68,6 +76,8 @@ int BethYw::run(int argc, char *argv[]) {
 
   try{
       BethYw::parseDatasetsArg(args);
+      BethYw::parseJSONBackendArg(args);
+      BethYw::parseThreadsArg(args);
   } catch (const std::invalid_argument &e){
       std::cerr << e.what() << "\n";
       exit(1);
@@ -79,15 +89,27 @@ int BethYw::run(int argc, char *argv[]) {
   auto yearsFilter      = BethYw::parseYearsArg(args);
 
   Areas data = Areas();
+  data.setJSONBackend(BethYw::parseJSONBackendArg(args));
+  data.setThreads(BethYw::parseThreadsArg(args));
+
+  // Start reading the datasets from disk whilst areas.csv is imported
+  BethYw::prefetchDatasets(dir, datasetsToImport);
 
   BethYw::loadAreas(data, dir, areasFilter);
 
+  // Parse the pages directory argument, if any
+  std::string pagesDir;
+  if (args.count("pages")) {
+    pagesDir = args["pages"].as<std::string>() + DIR_SEP;
+  }
+
   BethYw::loadDatasets(data,
                        dir,
                        datasetsToImport,
                        areasFilter,
                        measuresFilter,
-                       yearsFilter);
+                       yearsFilter,
+                       pagesDir);
 
   if (args.count("json")) {
     // The output as JSON
@@ -146,6 +168,25 @@ cxxopts::Options BethYw::cxxoptsSetup() {
       "j,json",
       "Print the output as JSON instead of tables.")(
 
+      "json-backend",
+      "The backend used to read StatsWales JSON files: scan, simd, sax or dom",
+      cxxopts::value<std::string>()->default_value("scan"))(
+
+      "pages",
+      "Directory holding the pages that StatsWales JSON files link to with "
+      "odata.nextLink, which are imported after the first page "
+      "(omit to only import the first page)",
+      cxxopts::value<std::string>())(
+
+      "manifest",
+      "A JSON file registering more datasets that can be imported (defaults "
+      "to " + MANIFEST_FILE + " in the data directory, if there is one)",
+      cxxopts::value<std::string>())(
+      "t,threads",
+      "The number of threads used to import the datasets, and to read each "
+      "StatsWales JSON file (set to 0 to use one per CPU core)",
+      cxxopts::value<std::string>()->default_value("1"))(
+
       "h,help",
       "Print usage.");
 
@@ -166,61 +207,63 @@ cxxopts::Options BethYw::cxxoptsSetup() {
   @return
     A std::vector of BethYw::InputFileSource instances to import
 
+  Datasets registered in a manifest (see registry.h) can be imported as well
+  as those built into the program. The manifest is given with the manifest
+  argument, or otherwise is the file manifest.json in the data directory, if
+  there is one.
+
   @throws
     std::invalid_argument if the argument contains an invalid dataset with
-    message: No dataset matches key <input code>
+    message: No dataset matches key <input code>, or the manifest is malformed
  */
 std::vector<BethYw::InputFileSource> BethYw::parseDatasetsArg(
     cxxopts::ParseResult& args) {
 
-    // Retrieve all valid datasets, see datasets.h
-    size_t numDatasets = InputFiles::NUM_DATASETS;
-    auto &allDatasets = InputFiles::DATASETS;
+    // Datasets are looked up in the built-in datasets (see datasets.h), and
+    // then in the manifest, which is only read if it is needed
+    std::string manifestPath;
+    bool manifestRequired = args.count("manifest") > 0;
+    if(manifestRequired){
+        manifestPath = args["manifest"].as<std::string>();
+    } else {
+        manifestPath = args["dir"].as<std::string>() + DIR_SEP + MANIFEST_FILE;
+    }
+    DatasetRegistry registry(manifestPath, manifestRequired);
 
     // Create the container for the return type
     std::vector<InputFileSource> datasetsToImport;
 
-    /*
-     * If there are arguments for datasets, we check does it include an "all" argument
-     * if not, we then loop through datasets to check if the Code and the argument is the same/
-     * If they are the same, we add that dataset into datasetsToImport. Otherwise we ignore it.
-     * If there are invalid argument, we throw std::invalid_argument exception
-     */
+    // Import all data if there are no arguments
+    std::vector<std::string> codes = {"all"};
     if(args.count("datasets") > 0){
-        // Retrieve the areas argument like so:
-        auto temp = args["datasets"].as<std::vector<std::string>>();
+        codes = args["datasets"].as<std::vector<std::string>>();
+    }
 
-        // Loop through all the argument
-        for(size_t i = 0; i < temp.size(); i++){
-            //If the argument contains "all" we clear the whole vector
-            // and import all the datasets
-            if(temp.at(i).compare("all") == 0){
+    /*
+     * If the arguments include an "all" argument, we import every dataset.
+     * Otherwise we look up the dataset for each argument, and add it to
+     * datasetsToImport. If there are invalid argument, we throw
+     * std::invalid_argument exception
+     */
+    try{
+        for(const auto& code : codes){
+            if(code.compare("all") == 0){
                 datasetsToImport.clear();
-                for(size_t j = 0; j < numDatasets; j++){
-                    datasetsToImport.push_back(allDatasets[j]);
+                for(const auto& registered : registry.getCodes()){
+                    datasetsToImport.push_back(registry.at(registered));
                 }
                 break;
-            } else {
-                // If there is an invalid Argument we throw an exception
-                // Otherwise, we add the dataset to the vector
-                bool invalidArgument = true;
-                for(size_t j = 0; j < numDatasets; j++){
-                    if(temp.at(i).compare(allDatasets[j].CODE) == 0){
-                        invalidArgument = false;
-                        datasetsToImport.push_back(allDatasets[j]);
-                    }
-                }
-                if(invalidArgument){
-                    throw std::invalid_argument("No dataset matches key: " + temp.at(i));
-                }
             }
+
+            const InputFileSource *source = registry.find(code);
+            if(source == nullptr){
+                throw std::invalid_argument("No dataset matches key: " + code);
+            }
+            datasetsToImport.push_back(*source);
         }
-    } else {
-        // Import all data if there are no arguments
-        for(size_t j = 0; j < numDatasets; j++){
-            datasetsToImport.push_back(allDatasets[j]);
-        }
-        return datasetsToImport;
+    } catch(const std::runtime_error &e){
+        // A malformed manifest is reported like an invalid argument
+        throw std::invalid_argument(e.what());
     }
     return datasetsToImport;
 }
@@ -449,6 +492,69 @@ std::tuple<unsigned int, unsigned int>BethYw::parseYearsArg(
 
     return years;
 }
+/*
+  Parse the json-backend argument passed into the command line.
+
+  The argument is optional, and defaults to "scan". It selects how StatsWales
+  JSON files are read (case-insensitive):
+    scan: a streaming JSONScanner
+    simd: a JSONIndexScanner, which builds a structural index with SIMD
+          instructions
+    sax:  the nlohmann JSON library's SAX parser
+    dom:  the nlohmann JSON library's DOM parser
+
+  @param args
+    Parsed program arguments
+
+  @return
+    The JSONBackend to use
+
+  @throws
+    std::invalid_argument if the argument is not one of the backends above with
+    the message: No JSON backend matches key: <input>
+*/
+JSONBackend BethYw::parseJSONBackendArg(cxxopts::ParseResult& args){
+    std::string backend = args["json-backend"].as<std::string>();
+    std::string key = backend;
+    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+
+    if(key == "scan"){
+        return JSONBackend::Scan;
+    } else if(key == "simd"){
+        return JSONBackend::SIMD;
+    } else if(key == "sax"){
+        return JSONBackend::SAX;
+    } else if(key == "dom"){
+        return JSONBackend::DOM;
+    }
+
+    throw std::invalid_argument("No JSON backend matches key: " + backend);
+}
+
+/*
+  Parse the threads argument passed into the command line.
+
+  The argument is optional, and defaults to 1. It is the number of threads
+  used to read each StatsWales JSON file, where 0 means one per CPU core.
+
+  @param args
+    Parsed program arguments
+
+  @return
+    The number of threads
+
+  @throws
+    std::invalid_argument if the argument is not a number between 0 and 9999
+    with the message: Invalid input for threads argument
+*/
+unsigned int BethYw::parseThreadsArg(cxxopts::ParseResult& args){
+    std::string str = args["threads"].as<std::string>();
+    if(!BethYw::isNumber(str) || str.size() > 4){
+        throw std::invalid_argument("Invalid input for threads argument");
+    }
+    return std::stoi(str);
+}
+
 /*
  * This function checks if the string input is a number
  *
@@ -497,7 +603,7 @@ void BethYw::loadAreas(Areas& areas, const std::string dir, const std::unordered
     ss << dir << BethYw::InputFiles::AREAS.FILE;
     dirTemp = ss.str();
 
-    InputFile inputFile(dirTemp);
+    InputMappedFile inputFile(dirTemp);
 
     try{
         inputFile.open();
@@ -526,6 +632,127 @@ void BethYw::loadAreas(Areas& areas, const std::string dir, const std::unordered
 }
 
 
+/*
+  Ask for the files of the datasets in `datasetsToImport` to be read into
+  memory in the background (see InputMappedFile::prefetch()), so that
+  reading them from disk overlaps with importing areas.csv and the datasets
+  before them. Any file that cannot be opened is left for loadDatasets() to
+  report.
+
+  @param dir
+    The directory where the datasets are
+
+  @param datasetsToImport
+    A vector of InputFileSource objects
+
+  @return
+    void
+*/
+void BethYw::prefetchDatasets(const std::string dir,
+                              const std::vector<BethYw::InputFileSource> &datasetsToImport){
+    for(const auto& source : datasetsToImport){
+        InputMappedFile::prefetch(dir + source.FILE);
+    }
+}
+
+/*
+  Import a single dataset from a file into areas. This is the work of
+  loadDatasets() for one dataset, except that errors are returned rather than
+  output, so that datasets imported at the same time can report their errors
+  in order.
+
+  @param areas
+    An Areas instance that should be modified (i.e. the dataset loaded into it)
+
+  @param path
+    The path of the dataset's file
+
+  @param source
+    The InputFileSource of the dataset
+
+  @param areasFilter, measuresFilter, yearsFilter
+    See loadDatasets()
+
+  @param pagesDir
+    See loadDatasets()
+
+  @param error
+    Set to the what() of the exception thrown if the dataset could not be
+    opened or imported, or left empty
+
+  @return
+    false if the dataset's file could not be opened, true otherwise (even if
+    there was an error importing it)
+*/
+bool BethYw::importDataset(Areas& areas,
+                           const std::string& path,
+                           const BethYw::InputFileSource& source,
+                           const std::unordered_set<std::string>& areasFilter,
+                           const std::unordered_set<std::string>& measuresFilter,
+                           const std::tuple<unsigned int, unsigned int>& yearsFilter,
+                           const std::string& pagesDir,
+                           std::string& error){
+
+    auto type = source.PARSER;
+    auto cols = source.COLS;
+
+    // StatsWales JSON files are the first page of a larger dataset, and
+    // the rest of the pages are imported in order after it
+    if(!pagesDir.empty() && type == BethYw::WelshStatsJSON){
+        InputPages inputPages(path, pagesDir);
+
+        try{
+            inputPages.open();
+        }catch (const std::runtime_error &e) {
+            error = e.what();
+            return false;
+        }
+
+        auto &is = inputPages.open();
+
+        try{
+            do {
+                areas.populate(is, type, cols, &areasFilter, &measuresFilter, &yearsFilter);
+            } while(inputPages.next());
+        } catch (const std::runtime_error &e){
+            error = e.what();
+        } catch(const std::out_of_range &e){
+            error = e.what();
+        }
+        return true;
+    }
+
+    InputMappedFile inputFile(path);
+
+    try{
+        inputFile.open();
+    }catch (const std::runtime_error &e) {
+        error = e.what();
+        return false;
+    }
+
+    auto &is = inputFile.open();
+
+    try{
+        // A StatsWales JSON file imported for some areas or measures is read
+        // through the index of its records, so that only the records needed
+        // are read
+        RecordIndex index(path + BethYw::INDEX_SUFFIX);
+        if(type == BethYw::WelshStatsJSON && (!areasFilter.empty() || !measuresFilter.empty()) &&
+           inputFile.getCompression() == Compression::None &&
+           index.open(path, inputFile.data(), inputFile.size(), cols)){
+            areas.populateFromWelshStatsJSON(is, cols, &areasFilter, &measuresFilter, &yearsFilter, &index);
+        } else {
+            areas.populate(is, type, cols, &areasFilter, &measuresFilter, &yearsFilter);
+        }
+    } catch (const std::runtime_error &e){
+        error = e.what();
+    } catch(const std::out_of_range &e){
+        error = e.what();
+    }
+    return true;
+}
+
 /*
   Import datasets from `datasetsToImport` as files in `dir` into areas, and
   filtering them with the `areasFilter`, `measuresFilter`, and `yearsFilter`.
@@ -538,6 +765,20 @@ void BethYw::loadAreas(Areas& areas, const std::string dir, const std::unordered
   output 'Error importing dataset:', followed by a new line and then the output
   of the what() function on the exception.
 
+  If areas has been set to use more than one thread (see Areas::setThreads()),
+  the datasets are imported at the same time on a pool of that many threads,
+  each into an Areas object of its own. These are then merged into areas (and
+  any errors output) in the order of datasetsToImport, so the result is the
+  same as importing the datasets one after the other. Any threads left over
+  are shared out between the datasets to read each StatsWales JSON file.
+
+  If areas, measures or years are filtered, a dataset that the catalog in
+  `dir` (see DatasetCatalog) shows cannot add anything to areas with these
+  filters is not imported at all. A dataset that is not in the catalog is
+  summarised first only if the catalog can be saved, and otherwise just
+  imported. If nothing is filtered, any dataset that is not in the catalog
+  is summarised from what is imported from it.
+
   @param areas
     An Areas instance that should be modified (i.e. datasets loaded into it)
 
@@ -559,6 +800,10 @@ void BethYw::loadAreas(Areas& areas, const std::string dir, const std::unordered
     An two-pair tuple of unsigned ints corresponding to the range of years 
     to import, which should both be 0 to import all years.
 
+  @param pagesDir
+    The directory holding the pages that StatsWales JSON files link to (see
+    InputPages), or an empty string to only import the file itself
+
   @return
     void
 */
@@ -567,47 +812,143 @@ void BethYw::loadDatasets(Areas& areas,
                           const std::vector<BethYw::InputFileSource> datasetsToImport,
                           const std::unordered_set<std::string>areasFilter,
                           const std::unordered_set<std::string>measuresFilter,
-                          const std::tuple<unsigned int, unsigned int> yearsFilter){
-
-    // Loop through every datasetsToImport
-    for(auto it = datasetsToImport.begin(); it != datasetsToImport.end(); it++){
-        std::stringstream ss;
-        // Get file directory for each datasets
-        ss << dir << it->FILE;
-        std::string dirTemp;
-        dirTemp = ss.str();
-
-        InputFile inputFile(dirTemp);
+                          const std::tuple<unsigned int, unsigned int> yearsFilter,
+                          const std::string pagesDir){
+
+    std::size_t numDatasets = datasetsToImport.size();
+    unsigned int workers = static_cast<unsigned int>(
+        std::min<std::size_t>(areas.getThreads(), numDatasets));
+
+    // The datasets imported so far, and the errors importing them
+    std::vector<Areas> imported(numDatasets);
+    std::vector<std::string> errors(numDatasets);
+    std::vector<char> opened(numDatasets, false);
+    std::vector<std::exception_ptr> exceptions(numDatasets);
+    for(auto& dataset : imported){
+        dataset.setJSONBackend(areas.getJSONBackend());
+        dataset.setThreads(workers > 1 ? std::max(areas.getThreads() / workers, 1u)
+                                       : areas.getThreads());
+    }
 
-        try{
-            inputFile.open();
-        }catch (const std::runtime_error &e) {
-            std::cerr << "Error importing dataset:" << "\n";
-            std::cerr <<  e.what() << "\n";
-            exit(1);
+    // The summaries of the datasets in the catalog. With filters, datasets
+    // are summarised if need be, and those that cannot change areas are
+    // skipped: datasets only ever add to areas, so if one cannot change the
+    // areas there are now, it cannot change them after the datasets before it
+    // either. Without filters, every dataset is imported in full, and those
+    // not in the catalog are summarised as they are.
+    bool filtered = !areasFilter.empty() || !measuresFilter.empty() ||
+                    yearsFilter != std::make_tuple(0u, 0u);
+    DatasetCatalog catalog(dir + BethYw::CATALOG_FILE);
+    std::vector<DatasetSummary> summaries(numDatasets);
+    std::vector<char> summarised(numDatasets, false);
+    std::vector<char> skipped(numDatasets, false);
+    for(std::size_t i = 0; i < numDatasets; i++){
+        // Only the first page of a paginated dataset could be summarised
+        if(!pagesDir.empty() && datasetsToImport[i].PARSER == BethYw::WelshStatsJSON){
+            summarised[i] = true;
+            continue;
         }
 
-        auto &is = inputFile.open();
+        std::string path = dir + datasetsToImport[i].FILE;
+        if(filtered){
+            // Summarising a dataset that is not in the catalog imports the
+            // whole file, which is only worth it if the summary can be saved
+            // for later runs. Otherwise the dataset is just imported.
+            summarised[i] = catalog.find(path, datasetsToImport[i], summaries[i]);
+            if(!summarised[i] && catalog.canSave()){
+                summaries[i] = catalog.summarise(path, datasetsToImport[i]);
+                summarised[i] = true;
+            }
+            skipped[i] = summarised[i] &&
+                         summaries[i].canSkip(areas.getAreaContainer(), areasFilter,
+                                              measuresFilter, yearsFilter);
+        } else {
+            summarised[i] = catalog.find(path, datasetsToImport[i], summaries[i]);
+        }
+    }
+    catalog.save();
+
+    if(workers > 1){
+        // The datasets with the most values are started first, so that the
+        // last to finish is a small one. Those not summarised yet could be
+        // any size, so they come first of all.
+        std::vector<std::size_t> order;
+        for(std::size_t i = 0; i < numDatasets; i++){
+            if(!skipped[i]){
+                order.push_back(i);
+            }
+        }
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b){
+            if(summarised[a] != summarised[b]){
+                return !summarised[a];
+            }
+            return summaries[a].values > summaries[b].values;
+        });
+
+        // Each thread takes the next dataset that has not been started yet
+        std::atomic<std::size_t> next(0);
+        std::vector<std::thread> pool;
+        for(unsigned int t = 0; t < workers; t++){
+            pool.emplace_back([&](){
+                for(std::size_t k = next++; k < order.size(); k = next++){
+                    std::size_t i = order[k];
+                    try{
+                        opened[i] = BethYw::importDataset(imported[i], dir + datasetsToImport[i].FILE,
+                                                          datasetsToImport[i], areasFilter,
+                                                          measuresFilter, yearsFilter, pagesDir,
+                                                          errors[i]);
+                    } catch(...){
+                        exceptions[i] = std::current_exception();
+                    }
+                }
+            });
+        }
+        for(auto& thread : pool){
+            thread.join();
+        }
+    }
 
-        //auto type = InputFiles::AREAS.PARSER;
-        auto type = it->PARSER;
+    // Loop through every datasetsToImport
+    for(std::size_t i = 0; i < numDatasets; i++){
+        if(skipped[i]){
+            continue;
+        }
 
-        //auto cols = InputFiles::AREAS.COLS;
-        auto cols = it->COLS;
+        // A dataset that is imported by itself (on a thread, or to summarise
+        // it) is merged into areas afterwards. Only a dataset imported in full
+        // can be summarised from what is imported.
+        bool recording = !filtered && !summarised[i];
+        bool separate = workers > 1 || recording;
+        if(workers > 1){
+            if(exceptions[i]){
+                std::rethrow_exception(exceptions[i]);
+            }
+        } else {
+            opened[i] = BethYw::importDataset(separate ? imported[i] : areas,
+                                              dir + datasetsToImport[i].FILE,
+                                              datasetsToImport[i], areasFilter,
+                                              measuresFilter, yearsFilter, pagesDir,
+                                              errors[i]);
+        }
 
-        try{
-            areas.populate(is, type, cols, &areasFilter, &measuresFilter, &yearsFilter);
-        } catch (const std::runtime_error &e){
+        if(!opened[i]){
             std::cerr << "Error importing dataset:" << "\n";
-            std::cerr << "what(): " << e.what() << "\n";
-        } catch(const std::out_of_range &e){
+            std::cerr <<  errors[i] << "\n";
+            exit(1);
+        } else if(!errors[i].empty()){
             std::cerr << "Error importing dataset:" << "\n";
-            std::cerr << "what(): " << e.what() << "\n";
+            std::cerr << "what(): " << errors[i] << "\n";
         }
 
+        if(recording){
+            catalog.record(dir + datasetsToImport[i].FILE, datasetsToImport[i],
+                           imported[i], errors[i].empty());
+        }
+        if(separate){
+            areas.merge(imported[i]);
+        }
     }
-
-
+    catalog.save();
 }
 
 
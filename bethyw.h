@@ -38,6 +38,24 @@ namespace BethYw {
 */
 const std::string STUDENT_NUMBER = "690826";
 
+/*
+  The name of the manifest file in the data directory that registers more
+  datasets (see registry.h).
+*/
+const std::string MANIFEST_FILE = "manifest.json";
+
+/*
+  The name of the file in the data directory that the summaries of the
+  datasets are kept in (see catalog.h).
+*/
+const std::string CATALOG_FILE = ".bethyw-catalog.json";
+
+/*
+  The suffix added to the path of a StatsWales JSON file to give the path of
+  the index of its records (see recordindex.h).
+*/
+const std::string INDEX_SUFFIX = ".bethyw-index";
+
 /*
   Run Beth Yw?, parsing the command line arguments and acting upon them.
 */
@@ -65,16 +83,41 @@ std::unordered_set<std::string> parseMeasuresArg(cxxopts::ParseResult& args);
 
 std::tuple<unsigned int, unsigned int> parseYearsArg(cxxopts::ParseResult& args);
 
+/*
+  Parse the json-backend argument and return the JSONBackend used to read
+  StatsWales JSON files.
+*/
+JSONBackend parseJSONBackendArg(cxxopts::ParseResult& args);
+
+/*
+  Parse the threads argument and return the number of threads used to import
+  the datasets, and to read each StatsWales JSON file.
+*/
+unsigned int parseThreadsArg(cxxopts::ParseResult& args);
+
 bool isNumber(const std::string& str);
 
 void loadAreas(Areas& areas, const std::string dir, const std::unordered_set<std::string>areasFilter);
 
+void prefetchDatasets(const std::string dir,
+                      const std::vector<BethYw::InputFileSource> &datasetsToImport);
+
+bool importDataset(Areas& areas,
+                   const std::string& path,
+                   const BethYw::InputFileSource& source,
+                   const std::unordered_set<std::string>& areasFilter,
+                   const std::unordered_set<std::string>& measuresFilter,
+                   const std::tuple<unsigned int, unsigned int>& yearsFilter,
+                   const std::string& pagesDir,
+                   std::string& error);
+
 void loadDatasets(Areas& areas,
                   const std::string dir,
                   const std::vector<BethYw::InputFileSource> datasetsToImport,
                   const std::unordered_set<std::string>areasFilter,
                   const std::unordered_set<std::string>measuresFilter,
-                  const std::tuple<unsigned int, unsigned int> yearsFilter);
+                  const std::tuple<unsigned int, unsigned int> yearsFilter,
+                  const std::string pagesDir = "");
 
 } // namespace BethYw
 
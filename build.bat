@@ -2,7 +2,7 @@
 
 SET bin_dir=bin
 SET tests_dir=tests
-SET source_files=bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp
+SET source_files=bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp jsonscan.cpp jsonindex.cpp numeric.cpp csvscan.cpp decompress.cpp registry.cpp catalog.cpp recordindex.cpp authoritycodes.cpp yearvalues.cpp recordbatch.cpp
 SET main_file=main.cpp
 SET executable=%bin_dir%\bethyw.exe
 
@@ -25,6 +25,6 @@ IF %testStr%==test (
 :compile
 IF NOT EXIST %bin_dir% MKDIR %bin_dir%
 IF EXIST %executable% DEL %executable%
-g++ --std=c++14 -Wall %source_files% %main_file% -o %executable%
+g++ --std=c++14 -Wall -pthread %source_files% %main_file% -o %executable%
 
 :end
@@ -2,7 +2,7 @@
 
 BIN_DIR="bin"
 TESTS_DIR="tests"
-SOURCE_FILES="bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp"
+SOURCE_FILES="bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp jsonscan.cpp jsonindex.cpp numeric.cpp csvscan.cpp decompress.cpp registry.cpp catalog.cpp recordindex.cpp authoritycodes.cpp yearvalues.cpp recordbatch.cpp"
 MAIN_FILE="main.cpp"
 EXECUTABLE="./${BIN_DIR}/bethyw"
 
@@ -25,6 +25,17 @@ elif [ $# -eq 1 ]; then
   fi
 fi
 
+# Compressed datasets can be read if zlib (gzip) is installed, and zstd ones if
+# libzstd is installed and BETHYW_WITH_ZSTD=1 is set, e.g.
+#   BETHYW_WITH_ZSTD=1 ./build.sh test20
+LIBRARIES=""
+if echo "#include <zlib.h>" | g++ -E -x c++ - > /dev/null 2>&1; then
+  LIBRARIES="${LIBRARIES} -DBETHYW_HAVE_ZLIB -lz"
+fi
+if [ "${BETHYW_WITH_ZSTD}" = "1" ]; then
+  LIBRARIES="${LIBRARIES} -DBETHYW_HAVE_ZSTD -lzstd"
+fi
+
 mkdir -p ${BIN_DIR}
 rm ${EXECUTABLE} 2> /dev/null
-g++ --std=c++14 -pedantic -Wall ${SOURCE_FILES} ${MAIN_FILE} -o ${EXECUTABLE}
\ No newline at end of file
+g++ --std=c++14 -pedantic -Wall -pthread ${SOURCE_FILES} ${MAIN_FILE} -o ${EXECUTABLE} ${LIBRARIES}
\ No newline at end of file
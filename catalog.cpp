@@ -0,0 +1,677 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the implementation of the DatasetCatalog class. See the
+  header file for an overview of how it is used.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "lib_json.hpp"
+
+#include "catalog.h"
+#include "input.h"
+#include "recordindex.h"
+
+using json = nlohmann::json;
+
+/*
+  The version of the catalog file format, which is increased whenever what is
+  summarised changes, so that old catalogs are summarised again.
+*/
+static const int CATALOG_VERSION = 4;
+
+// How much of the start and of the end of a file is hashed, as by RecordIndex
+static const std::size_t HASHED_SIZE = 64 * 1024;
+
+/*
+  This function finds what identifies the contents of a file: its size, its
+  modification time (in nanoseconds) and its inode (see ::fileStatus()), and
+  a hash of its first and last 64 KiB (see RecordIndex::hash()), which are
+  also what a RecordIndex sidecar file is checked against.
+
+  @param filePath
+    The path of the file
+
+  @param summary
+    Has its size, modified, inode and hash set from the file
+
+  @return
+    false if the file does not exist or cannot be read, true otherwise
+*/
+static bool fileStatus(const std::string &filePath, DatasetSummary &summary){
+    if (!fileStatus(filePath, summary.size, summary.modified, summary.inode)) {
+        return false;
+    }
+
+    // The start and end of the file are read one after the other, so that
+    // RecordIndex::hash() hashes the same bytes as it does for the whole file
+    std::ifstream ifs(filePath, std::ios::binary);
+    if (!ifs.is_open()) {
+        return false;
+    }
+    std::size_t size = static_cast<std::size_t>(summary.size);
+    std::size_t head = std::min(size, HASHED_SIZE);
+    std::size_t tail = std::min(size - head, HASHED_SIZE);
+    std::vector<char> data(head + tail);
+    ifs.read(data.data(), head);
+    ifs.seekg(static_cast<std::streamoff>(size - tail));
+    ifs.read(data.data() + head, tail);
+    if (!ifs) {
+        return false;
+    }
+    summary.hash = RecordIndex::hash(data.data(), data.size());
+    return true;
+}
+
+/*
+  This function determines whether two summaries are of the same contents of
+  a file, parsed in the same way.
+
+  @param summary, file
+    The summaries
+
+  @return
+    true if they are of the same contents
+*/
+static bool sameFile(const DatasetSummary &summary, const DatasetSummary &file){
+    return summary.size == file.size && summary.modified == file.modified &&
+           summary.inode == file.inode && summary.hash == file.hash;
+}
+
+/*
+  This function determines whether any year in the range [first, last] is
+  accepted by yearsFilter.
+
+  @param first, last
+    The range of years, which is empty if first > last
+
+  @param yearsFilter
+    The range of years to import, or <0,0> for all years
+
+  @return
+    true if a year in the range could be imported
+*/
+static bool overlaps(int first, int last, const YearFilterTuple &yearsFilter){
+    int minYear = static_cast<int>(std::get<0>(yearsFilter));
+    int maxYear = static_cast<int>(std::get<1>(yearsFilter));
+    if (first > last) {
+        return false;
+    }
+    if (minYear == 0 && maxYear == 0) {
+        return true;
+    }
+    return first <= maxYear && last >= minYear;
+}
+
+/*
+  This function widens a range of years to include another.
+
+  @param range
+    The range of years, which is empty if its first year is after its last
+
+  @param first, last
+    The range to include in it
+*/
+static void widen(std::pair<int, int> &range, int first, int last){
+    if (range.first > range.second) {
+        range = std::make_pair(first, last);
+    } else {
+        range.first = std::min(range.first, first);
+        range.second = std::max(range.second, last);
+    }
+}
+
+/*
+  Constructor for a PairFilter.
+
+  @param pairs
+    The number of pairs that will be added to it
+*/
+PairFilter::PairFilter(std::size_t pairs)
+    : bits(std::max<std::size_t>((pairs * 10 + 63) / 64, 1), 0), hashes(7) {}
+
+/*
+  This function hashes a pair (with 64-bit FNV-1a, and then a SplitMix64
+  step of that hash), giving the two hashes that the bits of the pair are
+  found from.
+
+  @param area, measure
+    The authority code and measure code
+
+  @param first, second
+    Set to the hashes
+*/
+void PairFilter::hash(const std::string &area, const std::string &measure,
+                      std::uint64_t &first, std::uint64_t &second){
+    std::uint64_t value = 14695981039346656037ULL;
+    auto add = [&value](const std::string &text) {
+        for (char c : text) {
+            value ^= static_cast<unsigned char>(c);
+            value *= 1099511628211ULL;
+        }
+        // Separates the area from the measure, so that e.g. ("ab", "c") and
+        // ("a", "bc") are different pairs
+        value ^= 0xff;
+        value *= 1099511628211ULL;
+    };
+    add(area);
+    add(measure);
+
+    first = value;
+    second = value + 0x9e3779b97f4a7c15ULL;
+    second = (second ^ (second >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    second = (second ^ (second >> 27)) * 0x94d049bb133111ebULL;
+    second = (second ^ (second >> 31)) | 1;
+}
+
+/*
+  This function adds a pair to the filter.
+
+  @param area, measure
+    The authority code and (lowercase) measure code
+*/
+void PairFilter::add(const std::string &area, const std::string &measure){
+    std::uint64_t first;
+    std::uint64_t second;
+    hash(area, measure, first, second);
+
+    std::uint64_t size = bits.size() * 64;
+    for (unsigned int i = 0; i < hashes; i++) {
+        std::uint64_t bit = (first + i * second) % size;
+        bits[bit / 64] |= std::uint64_t(1) << (bit % 64);
+    }
+}
+
+/*
+  This function determines whether a pair might have been added to the
+  filter.
+
+  @param area, measure
+    The authority code and (lowercase) measure code
+
+  @return
+    false if the pair was definitely not added, true if it might have been
+*/
+bool PairFilter::mayContain(const std::string &area, const std::string &measure) const{
+    std::uint64_t first;
+    std::uint64_t second;
+    hash(area, measure, first, second);
+
+    std::uint64_t size = bits.size() * 64;
+    for (unsigned int i = 0; i < hashes; i++) {
+        std::uint64_t bit = (first + i * second) % size;
+        if ((bits[bit / 64] & (std::uint64_t(1) << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+  These functions get and set the bits of the filter, to save it in and read
+  it from a catalog file. An empty filter is given one word of bits, with
+  none set.
+*/
+const std::vector<std::uint64_t> &PairFilter::getBits() const{
+    return bits;
+}
+
+void PairFilter::setBits(const std::vector<std::uint64_t> &bits){
+    this->bits = bits.empty() ? std::vector<std::uint64_t>(1, 0) : bits;
+}
+
+/*
+  This function determines whether importing the summarised dataset with a
+  set of filters would leave the imported data unchanged, so that the dataset
+  does not need to be read.
+
+  This must take into account everything the parser does with a record, not
+  just the values it imports: a StatsWales JSON record creates its Area if the
+  area is accepted, and its Measure if the measure is too, even when its year
+  is not. So such a file can only be skipped if all of the accepted areas in
+  it exist already, and so do those of their accepted measures that are not
+  ruled out by the pair filter. An AuthorityByYearCSV file only creates an
+  Area for a row with a value that is imported.
+
+  @param existing
+    The areas that will already have been imported when the dataset is
+
+  @param areasFilter, measuresFilter, yearsFilter
+    See Areas::populate()
+
+  @return
+    true if the dataset can be skipped
+*/
+bool DatasetSummary::canSkip(const AreasContainer &existing,
+                             const StringFilterSet &areasFilter,
+                             const StringFilterSet &measuresFilter,
+                             const YearFilterTuple &yearsFilter) const{
+    if (!valid || (parser != BethYw::WelshStatsJSON && parser != BethYw::AuthorityByYearCSV)) {
+        return false;
+    }
+
+    // Nothing is done with a record (or row) whose area is not accepted, so
+    // only the accepted areas in the file are looked at
+    std::vector<const std::string *> acceptedAreas;
+    if (areasFilter.empty()) {
+        for (const auto &area : areas) {
+            acceptedAreas.push_back(&area);
+        }
+    } else {
+        for (const auto &area : areasFilter) {
+            auto it = areas.find(area);
+            if (it != areas.end()) {
+                acceptedAreas.push_back(&*it);
+            }
+        }
+    }
+
+    std::vector<std::pair<const std::string *, bool>> acceptedMeasures;
+    if (overlaps(years.first, years.second, yearsFilter) || parser == BethYw::WelshStatsJSON) {
+        for (const auto &measure : measures) {
+            if (measuresFilter.empty() || measuresFilter.find(measure.first) != measuresFilter.end()) {
+                bool valueAccepted = overlaps(measure.second.first, measure.second.second, yearsFilter);
+                acceptedMeasures.emplace_back(&measure.first, valueAccepted);
+            }
+        }
+    }
+
+    for (const std::string *area : acceptedAreas) {
+        auto it = existing.find(*area);
+        if (parser == BethYw::WelshStatsJSON && it == existing.end()) {
+            return false;
+        }
+
+        for (const auto &measure : acceptedMeasures) {
+            // The area definitely does not have the measure in the file
+            if (!pairs.mayContain(*area, *measure.first)) {
+                continue;
+            }
+            if (measure.second) {
+                return false;
+            }
+            if (parser == BethYw::WelshStatsJSON &&
+                it->second.measures.find(*measure.first) == it->second.measures.end()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+  Constructor for a DatasetCatalog, which does not read the catalog file until
+  a dataset is summarised.
+
+  @param path
+    The path of the catalog file
+
+  @example
+    DatasetCatalog catalog("datasets/" + BethYw::CATALOG_FILE);
+    DatasetSummary summary = catalog.summarise("datasets/popu1009.json",
+                                               BethYw::InputFiles::POPDEN);
+    catalog.save();
+*/
+DatasetCatalog::DatasetCatalog(const std::string &path)
+    : path(path), loaded(false), changed(false), writable(-1) {}
+
+/*
+  This function reads the catalog file. A catalog that is missing, malformed,
+  or from a different version of the program is ignored, as every summary in
+  it can be made again.
+*/
+void DatasetCatalog::load(){
+    if (loaded) {
+        return;
+    }
+    loaded = true;
+
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+        return;
+    }
+
+    try {
+        json catalog;
+        ifs >> catalog;
+        if (catalog.at("version").get<int>() != CATALOG_VERSION) {
+            return;
+        }
+
+        std::map<std::string, DatasetSummary> read;
+        for (const auto &entry : catalog.at("datasets").items()) {
+            const json &j = entry.value();
+            DatasetSummary &summary = read[entry.key()];
+            summary.valid = j.at("valid").get<bool>();
+            summary.parser = static_cast<BethYw::SourceDataType>(j.at("parser").get<int>());
+            summary.size = j.at("size").get<long long>();
+            summary.modified = j.at("modified").get<long long>();
+            summary.inode = j.at("inode").get<unsigned long long>();
+            summary.hash = j.at("hash").get<std::uint64_t>();
+            summary.signature = j.at("signature").get<std::string>();
+            summary.years = std::make_pair(j.at("years").at(0).get<int>(), j.at("years").at(1).get<int>());
+            summary.values = j.at("values").get<unsigned long long>();
+            for (const auto &measure : j.at("measures").items()) {
+                summary.measures.emplace(measure.key(),
+                                         std::make_pair(measure.value().at(0).get<int>(),
+                                                        measure.value().at(1).get<int>()));
+            }
+            for (const auto &area : j.at("areas")) {
+                summary.areas.insert(area.get<std::string>());
+            }
+            summary.pairs.setBits(j.at("pairs").get<std::vector<std::uint64_t>>());
+        }
+        summaries.swap(read);
+    } catch (const json::exception &e) {
+        summaries.clear();
+    }
+}
+
+/*
+  This function determines whether the catalog file can be written (e.g. the
+  data directory is not read-only), by creating and removing a temporary file
+  next to it. It is only tried once.
+
+  @return
+    true if save() can write the catalog file
+*/
+bool DatasetCatalog::canSave(){
+    if (writable < 0) {
+        const std::string temporary = temporaryFilePath(path);
+        writable = std::ofstream(temporary).is_open() ? 1 : 0;
+        std::remove(temporary.c_str());
+    }
+    return writable == 1;
+}
+
+/*
+  This function writes the catalog file, if any dataset has been summarised
+  since it was read. It is written to a temporary file of its own first (see
+  temporaryFilePath()), so that another run of the program never reads half
+  a catalog, even if it is saving the catalog at the same time. If the file
+  cannot be written, the summaries are simply made again next time, and
+  canSave() is false from then on.
+*/
+void DatasetCatalog::save(){
+    if (!changed) {
+        return;
+    }
+
+    json datasets = json::object();
+    for (const auto &entry : summaries) {
+        const DatasetSummary &summary = entry.second;
+        json measures = json::object();
+        for (const auto &measure : summary.measures) {
+            measures[measure.first] = {measure.second.first, measure.second.second};
+        }
+        datasets[entry.first] = {
+            {"valid", summary.valid},
+            {"parser", static_cast<int>(summary.parser)},
+            {"size", summary.size},
+            {"modified", summary.modified},
+            {"inode", summary.inode},
+            {"hash", summary.hash},
+            {"signature", summary.signature},
+            {"years", {summary.years.first, summary.years.second}},
+            {"values", summary.values},
+            {"measures", measures},
+            {"areas", summary.areas},
+            {"pairs", summary.pairs.getBits()}
+        };
+    }
+    json catalog = {{"version", CATALOG_VERSION}, {"datasets", datasets}};
+
+    const std::string temporary = temporaryFilePath(path);
+    {
+        std::ofstream ofs(temporary);
+        if (!ofs.is_open()) {
+            writable = 0;
+            return;
+        }
+        ofs << catalog.dump() << "\n";
+        if (!ofs) {
+            ofs.close();
+            std::remove(temporary.c_str());
+            writable = 0;
+            return;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        writable = 0;
+        return;
+    }
+    changed = false;
+}
+
+/*
+  This function finds the summary of a dataset file in the catalog, if it is
+  there and the file and the way it is parsed have not changed since it was
+  summarised.
+
+  @param filePath
+    The path of the dataset's file, which is in the catalog's directory
+
+  @param source
+    The InputFileSource of the dataset
+
+  @param summary
+    Set to the summary of the file, if it is found
+
+  @return
+    true if the summary was found
+*/
+bool DatasetCatalog::find(const std::string &filePath,
+                          const BethYw::InputFileSource &source,
+                          DatasetSummary &summary){
+    DatasetSummary file;
+    if (!fileStatus(filePath, file)) {
+        return false;
+    }
+
+    load();
+    auto it = summaries.find(source.FILE);
+    if (it == summaries.end() || !sameFile(it->second, file) || it->second.signature != signature(source)) {
+        return false;
+    }
+    summary = it->second;
+    return true;
+}
+
+/*
+  This function finds the summary of a dataset file, summarising it (see
+  scan()) if it is not in the catalog, or the file or the way it is parsed
+  has changed since it was.
+
+  @param filePath
+    The path of the dataset's file, which is in the catalog's directory
+
+  @param source
+    The InputFileSource of the dataset
+
+  @return
+    The summary of the file, which is not valid if the file does not exist
+    or could not be imported
+*/
+DatasetSummary DatasetCatalog::summarise(const std::string &filePath,
+                                         const BethYw::InputFileSource &source){
+    DatasetSummary summary;
+    if (find(filePath, source, summary)) {
+        return summary;
+    }
+
+    DatasetSummary file;
+    if (!fileStatus(filePath, file)) {
+        return summary;
+    }
+
+    summary = scan(filePath, source);
+    summary.size = file.size;
+    summary.modified = file.modified;
+    summary.inode = file.inode;
+    summary.hash = file.hash;
+    summaries[source.FILE] = summary;
+    changed = true;
+    return summary;
+}
+
+/*
+  This function records the summary of a dataset file that has just been
+  imported in full (i.e. with no filters), so that it does not need to be
+  read again to summarise it.
+
+  @param filePath
+    The path of the dataset's file, which is in the catalog's directory
+
+  @param source
+    The InputFileSource of the dataset
+
+  @param imported
+    The areas imported from the file, and nothing else
+
+  @param valid
+    Whether the file was imported without an error
+*/
+void DatasetCatalog::record(const std::string &filePath,
+                            const BethYw::InputFileSource &source,
+                            Areas &imported,
+                            bool valid){
+    DatasetSummary summary;
+    if (!fileStatus(filePath, summary)) {
+        return;
+    }
+    summary.parser = source.PARSER;
+    summary.signature = signature(source);
+    if (valid && canSummarise(source)) {
+        describe(imported, summary);
+    }
+
+    load();
+    summaries[source.FILE] = summary;
+    changed = true;
+}
+
+/*
+  This function makes a string identifying how a dataset is parsed, so that
+  a summary is made again if the dataset's parser or columns change.
+
+  @param source
+    The InputFileSource of the dataset
+
+  @return
+    The parser and column mapping as a string
+*/
+std::string DatasetCatalog::signature(const BethYw::InputFileSource &source){
+    std::map<int, std::string> cols(source.COLS.begin(), source.COLS.end());
+    json j = {{"parser", static_cast<int>(source.PARSER)}, {"cols", json::array()}};
+    for (const auto &col : cols) {
+        j["cols"].push_back({col.first, col.second});
+    }
+    return j.dump();
+}
+
+/*
+  This function determines whether a dataset's parser is one whose effect on
+  the imported data canSkip() knows.
+
+  @param source
+    The InputFileSource of the dataset
+
+  @return
+    true if the dataset can be summarised
+*/
+bool DatasetCatalog::canSummarise(const BethYw::InputFileSource &source){
+    return source.PARSER == BethYw::WelshStatsJSON || source.PARSER == BethYw::AuthorityByYearCSV;
+}
+
+/*
+  This function summarises a dataset file by importing all of it, with no
+  filters, so the summary is exactly what the parser finds in it.
+
+  @param filePath
+    The path of the dataset's file
+
+  @param source
+    The InputFileSource of the dataset
+
+  @return
+    The summary of the file, which is not valid if the file could not be
+    imported, or its parser is not one that can be summarised
+*/
+DatasetSummary DatasetCatalog::scan(const std::string &filePath,
+                                    const BethYw::InputFileSource &source){
+    DatasetSummary summary;
+    summary.parser = source.PARSER;
+    summary.signature = signature(source);
+    if (!canSummarise(source)) {
+        return summary;
+    }
+
+    StringFilterSet areasFilter;
+    StringFilterSet measuresFilter;
+    YearFilterTuple yearsFilter(0, 0);
+
+    Areas areas = Areas();
+    try {
+        InputMappedFile input(filePath);
+        areas.populate(input.open(), source.PARSER, source.COLS,
+                       &areasFilter, &measuresFilter, &yearsFilter);
+    } catch (const std::exception &e) {
+        return summary;
+    }
+
+    describe(areas, summary);
+    return summary;
+}
+
+/*
+  This function fills in a summary from everything imported from a dataset
+  file, and marks it as valid.
+
+  @param imported
+    The areas imported from the file, with no filters
+
+  @param summary
+    The summary to fill in
+*/
+void DatasetCatalog::describe(Areas &imported, DatasetSummary &summary){
+    std::size_t pairs = 0;
+    for (const auto &area : imported.getAreaContainer()) {
+        pairs += area.second.measures.size();
+    }
+    summary.pairs = PairFilter(pairs);
+
+    for (const auto &area : imported.getAreaContainer()) {
+        summary.areas.insert(area.first);
+        for (const auto &measure : area.second.measures) {
+            summary.pairs.add(area.first, measure.first);
+            auto range = summary.measures.emplace(measure.first, std::make_pair(1, 0)).first;
+            const YearValues &values = measure.second.getValues();
+            if (values.empty()) {
+                continue;
+            }
+            int first = values.front().first;
+            int last = values.back().first;
+            widen(range->second, first, last);
+            widen(summary.years, first, last);
+            summary.values += values.size();
+        }
+    }
+    summary.valid = true;
+}
@@ -0,0 +1,134 @@
+#ifndef CATALOG_H_
+#define CATALOG_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the declaration of the DatasetCatalog class, which keeps
+  a summary of what each dataset file contains (its measures, the years they
+  have values for, its areas, how many values it has, and a Bloom filter of
+  which areas have which measures), so that a dataset that cannot add anything
+  to the data imported with a set of filters does not need to be read at all.
+
+  A summary is made whenever a dataset is imported in full (i.e. with no
+  filters), or else by importing the whole file the first time it is needed,
+  and the catalog is kept in a file in the data directory (see
+  BethYw::CATALOG_FILE), so that later runs only need to check that each
+  dataset file has not changed since (by its size, modification time in
+  nanoseconds and inode, from fileStatus(), and a hash of its start and end,
+  which is also how a RecordIndex sidecar file is checked). The catalog is only
+  a cache: if it is missing, malformed or cannot be written, every dataset
+  is summarised again.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "areas.h"
+#include "datasets.h"
+
+/*
+  A Bloom filter over pairs of an authority code and a measure code, which
+  answers whether a pair might be in a dataset file, or definitely is not.
+  About ten bits are used per pair, so that roughly one pair in a hundred
+  that is not in the file is thought to be.
+*/
+class PairFilter {
+private:
+  std::vector<std::uint64_t> bits;
+  unsigned int hashes;
+
+  static void hash(const std::string &area, const std::string &measure,
+                   std::uint64_t &first, std::uint64_t &second);
+
+public:
+  PairFilter(std::size_t pairs = 0);
+
+  void add(const std::string &area, const std::string &measure);
+  bool mayContain(const std::string &area, const std::string &measure) const;
+
+  const std::vector<std::uint64_t> &getBits() const;
+  void setBits(const std::vector<std::uint64_t> &bits);
+};
+
+/*
+  A summary of a dataset file, as imported by a particular parser and column
+  mapping.
+*/
+struct DatasetSummary {
+  // Whether the file could be imported without an error. Nothing is known
+  // about a file that could not be, so it is never skipped.
+  bool valid = false;
+
+  // The parser, size, modification time (in nanoseconds), inode, and hash
+  // of the start and end of the file, and its column mapping, for checking
+  // whether the summary is out of date
+  BethYw::SourceDataType parser = BethYw::None;
+  long long size = 0;
+  long long modified = 0;
+  unsigned long long inode = 0;
+  std::uint64_t hash = 0;
+  std::string signature;
+
+  // The first and last year with a value in the file, and the number of
+  // values in it (i.e. of areas, measures and years with a value)
+  std::pair<int, int> years = std::make_pair(1, 0);
+  unsigned long long values = 0;
+
+  // The first and last year with a value for each measure (by its lowercase
+  // code), across every area
+  std::map<std::string, std::pair<int, int>> measures;
+
+  // The authority codes of the areas in the file
+  std::set<std::string> areas;
+
+  // The pairs of an area and a measure in the file
+  PairFilter pairs;
+
+  bool canSkip(const AreasContainer &existing,
+               const StringFilterSet &areasFilter,
+               const StringFilterSet &measuresFilter,
+               const YearFilterTuple &yearsFilter) const;
+};
+
+class DatasetCatalog {
+private:
+  std::string path;
+  bool loaded;
+  bool changed;
+
+  // Whether the catalog file can be written: 0 if not, 1 if so, or -1 if it
+  // has not been tried yet
+  int writable;
+
+  // The summary of each dataset file, by its file name
+  std::map<std::string, DatasetSummary> summaries;
+
+  void load();
+
+  static bool canSummarise(const BethYw::InputFileSource &source);
+  static void describe(Areas &imported, DatasetSummary &summary);
+
+public:
+  DatasetCatalog(const std::string &path);
+
+  bool find(const std::string &filePath, const BethYw::InputFileSource &source, DatasetSummary &summary);
+  DatasetSummary summarise(const std::string &filePath, const BethYw::InputFileSource &source);
+  void record(const std::string &filePath, const BethYw::InputFileSource &source, Areas &imported, bool valid);
+  bool canSave();
+  void save();
+
+  static std::string signature(const BethYw::InputFileSource &source);
+  static DatasetSummary scan(const std::string &filePath, const BethYw::InputFileSource &source);
+};
+
+#endif // CATALOG_H_
@@ -0,0 +1,327 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the implementation of the CSVScanner class. See the
+  header file for an overview of how the scanner is used.
+
+  Each row is split into fields by classifying its bytes 64 at a time into
+  bitmasks of commas, line feeds and quotes. In RFC 4180 a quote inside a
+  quoted field is written as "", so the bytes inside quotes are exactly those
+  with an odd number of quotes before them, which is the prefix XOR of the
+  quote mask. The commas and line feeds outside quotes end fields and rows.
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "csvscan.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BETHYW_HAVE_SSE2
+#endif
+
+/*
+  Bitmasks for a 64-byte block of the input, where bit i is set if byte i of
+  the block is a comma, a line feed or a quote.
+*/
+struct CSVBlockMasks {
+    std::uint64_t comma;
+    std::uint64_t newline;
+    std::uint64_t quote;
+};
+
+/*
+  Classify a 64-byte block of the input.
+*/
+static CSVBlockMasks classifyCSV(const char *block){
+    CSVBlockMasks masks = {0, 0, 0};
+#ifdef BETHYW_HAVE_SSE2
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i quote = _mm_set1_epi8('"');
+
+    for (int i = 0; i < 4; i++) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * i));
+        int shift = 16 * i;
+        masks.comma |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, comma)))) << shift;
+        masks.newline |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)))) << shift;
+        masks.quote |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+    }
+#else
+    for (int i = 0; i < 64; i++) {
+        std::uint64_t bit = std::uint64_t(1) << i;
+        switch (block[i]) {
+            case ',':
+                masks.comma |= bit;
+                break;
+            case '\n':
+                masks.newline |= bit;
+                break;
+            case '"':
+                masks.quote |= bit;
+                break;
+        }
+    }
+#endif
+    return masks;
+}
+
+/*
+  Returns the index of the lowest set bit of x, which must not be 0.
+*/
+static inline int lowestBit(std::uint64_t x){
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int i = 0;
+    while ((x & 1) == 0) {
+        x >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+/*
+  Returns a mask where bit i is the XOR of bits 0 to i of x.
+*/
+static inline std::uint64_t prefixXor(std::uint64_t x){
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+/*
+  Construct a CSVScanner that reads from a standard input stream.
+
+  @param is
+    The input stream to read
+
+  @param blockSize
+    The number of bytes to read from the stream at once
+
+  @example
+    std::ifstream is("datasets/areas.csv");
+    CSVScanner scanner(is);
+*/
+CSVScanner::CSVScanner(std::istream &is, std::size_t blockSize)
+    : is(is), blockSize(blockSize), rowStart(0), scanned(0), filled(0),
+      inQuotes(false){
+
+}
+
+/*
+  This function reads the next block of the input stream into the buffer,
+  first discarding the rows that have already been read.
+
+  @return
+    true if more input was read, false at the end of the input
+*/
+bool CSVScanner::fill(){
+    if (!is.good()) {
+        return false;
+    }
+
+    if (rowStart > 0) {
+        std::memmove(buffer.data(), buffer.data() + rowStart, filled - rowStart);
+        filled -= rowStart;
+        scanned -= rowStart;
+        rowStart = 0;
+    }
+
+    // A row longer than a block makes the buffer grow
+    if (buffer.size() < filled + blockSize) {
+        buffer.resize(filled + blockSize);
+    }
+
+    is.read(buffer.data() + filled, blockSize);
+    std::size_t read = static_cast<std::size_t>(is.gcount());
+    filled += read;
+    return read > 0;
+}
+
+/*
+  This function continues splitting the current row into fields, from where
+  it last stopped to the end of the buffer.
+
+  @param rowEnd
+    Set to the offset of the line feed that ends the row, if it was found
+
+  @return
+    true if the end of the row was found, false if more input is needed
+*/
+bool CSVScanner::scanRow(std::size_t &rowEnd){
+    char tail[64];
+
+    while (scanned < filled) {
+        const char *block = buffer.data() + scanned;
+        std::size_t length = filled - scanned;
+        if (length < 64) {
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, block, length);
+            block = tail;
+        } else {
+            length = 64;
+        }
+
+        CSVBlockMasks masks = classifyCSV(block);
+        std::uint64_t quoted = prefixXor(masks.quote) ^ (inQuotes ? ~std::uint64_t(0) : 0);
+        std::uint64_t delimiters = (masks.comma | masks.newline) & ~quoted;
+
+        while (delimiters != 0) {
+            std::size_t position = scanned + lowestBit(delimiters);
+            fieldEnds.push_back(position - rowStart);
+            if (buffer[position] == '\n') {
+                rowEnd = position;
+                scanned = position + 1;
+                inQuotes = false;
+                return true;
+            }
+            delimiters &= delimiters - 1;
+        }
+
+        inQuotes = (quoted >> (length - 1)) & 1;
+        scanned += length;
+    }
+    return false;
+}
+
+/*
+  This function adds a field of the current row, removing the quotes around
+  it (and unescaping any quotes inside it) if it is quoted.
+
+  @param begin
+    The offset in the buffer of the first character of the field
+
+  @param end
+    The offset in the buffer of one past the last character of the field
+*/
+void CSVScanner::addField(std::size_t begin, std::size_t end){
+    char *first = buffer.data() + begin;
+    char *last = buffer.data() + end;
+
+    if (first != last && *first == '"') {
+        // The unescaped field is never longer, so it is written in place
+        char *out = first;
+        for (const char *p = first + 1; p < last; p++) {
+            if (*p != '"') {
+                *out++ = *p;
+            } else if (p + 1 < last && p[1] == '"') {
+                *out++ = '"';
+                p++;
+            }
+        }
+        last = out;
+    }
+
+    fields.push_back(CSVField{first, last});
+}
+
+/*
+  This function reads the next row, whose fields can then be accessed with
+  operator[] or at(). The fields of the previous row are no longer valid.
+
+  @return
+    true if a row was read, false at the end of the input
+
+  @throws
+    std::runtime_error if the input ends inside a quoted field
+*/
+bool CSVScanner::nextRow(){
+    for (;;) {
+        fields.clear();
+        fieldEnds.clear();
+
+        std::size_t rowEnd = 0;
+        bool complete = scanRow(rowEnd);
+        while (!complete && fill()) {
+            complete = scanRow(rowEnd);
+        }
+
+        if (!complete) {
+            if (inQuotes) {
+                throw std::runtime_error("CSVScanner: unterminated quoted field");
+            } else if (rowStart == filled) {
+                return false;
+            }
+            // The last row does not have to end with a line feed
+            rowEnd = filled;
+            fieldEnds.push_back(filled - rowStart);
+        }
+
+        // A row ending "\r\n" has the carriage return removed
+        if (rowEnd > rowStart && buffer[rowEnd - 1] == '\r') {
+            fieldEnds.back()--;
+        }
+
+        std::size_t begin = rowStart;
+        for (std::size_t end : fieldEnds) {
+            addField(begin, rowStart + end);
+            begin = rowStart + end + 1;
+        }
+
+        rowStart = rowEnd < filled ? rowEnd + 1 : filled;
+        scanned = rowStart;
+
+        if (fields.size() > 1 || !fields.front().empty()) {
+            return true;
+        }
+    }
+}
+
+/*
+  This function gets the number of fields in the current row.
+
+  @return
+    The number of fields
+*/
+std::size_t CSVScanner::size() const{
+    return fields.size();
+}
+
+/*
+  This function gets a field of the current row, without checking that it
+  exists.
+
+  @param index
+    The index of the field, starting from 0
+
+  @return
+    The field
+*/
+const CSVField &CSVScanner::operator[](std::size_t index) const{
+    return fields[index];
+}
+
+/*
+  This function gets a field of the current row.
+
+  @param index
+    The index of the field, starting from 0
+
+  @return
+    The field
+
+  @throws
+    std::out_of_range if the row has fewer fields
+*/
+const CSVField &CSVScanner::at(std::size_t index) const{
+    if (index >= fields.size()) {
+        throw std::out_of_range("CSVScanner: there is no field " + std::to_string(index) + " in the row");
+    }
+    return fields[index];
+}
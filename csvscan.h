@@ -0,0 +1,96 @@
+#ifndef CSVSCAN_H_
+#define CSVSCAN_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the declaration of the CSVScanner class, a tokenizer for
+  comma-separated values files (RFC 4180) used to import areas.csv and the
+  authority-by-year CSV files.
+
+  Rather than copying each field of a row into a std::string, CSVScanner
+  reads the input in large blocks into a buffer that is reused for the whole
+  file, and gives the fields of each row as CSVField views of that buffer.
+  The delimiters of a row are found 16 bytes at a time with SSE2 where it is
+  available.
+ */
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+/*
+  A field of a row read by a CSVScanner. It points into the scanner's buffer,
+  so it is only valid until the next row is read.
+*/
+struct CSVField {
+  const char *first;
+  const char *last;
+
+  const char *begin() const { return first; }
+  const char *end() const { return last; }
+  std::size_t size() const { return last - first; }
+  bool empty() const { return first == last; }
+
+  std::string str() const { return std::string(first, last); }
+  bool operator==(const std::string &other) const {
+    return other.compare(0, std::string::npos, first, size()) == 0;
+  }
+};
+
+/*
+  CSVScanner reads a CSV file from a standard input stream one row at a time,
+  e.g. to print every field of every row:
+
+    CSVScanner scanner(is);
+    while (scanner.nextRow()) {
+      for (std::size_t i = 0; i < scanner.size(); i++) {
+        std::cout << scanner[i].str() << std::endl;
+      }
+    }
+
+  Fields may be quoted with '"', in which case they may contain commas, line
+  breaks and quotes (written as ""). Rows may end with "\n" or "\r\n", and
+  blank rows are skipped.
+*/
+class CSVScanner {
+private:
+  std::istream &is;
+  std::size_t blockSize;
+
+  // The input read so far that has not been returned as a row yet. The row
+  // being scanned starts at rowStart, and bytes before scanned have already
+  // been split into fields.
+  std::vector<char> buffer;
+  std::size_t rowStart;
+  std::size_t scanned;
+  std::size_t filled;
+  bool inQuotes;
+
+  // The fields of the current row
+  std::vector<CSVField> fields;
+
+  // The offsets from rowStart of the end of each field of the row being
+  // scanned
+  std::vector<std::size_t> fieldEnds;
+
+  bool fill();
+  bool scanRow(std::size_t &rowEnd);
+  void addField(std::size_t begin, std::size_t end);
+
+public:
+  explicit CSVScanner(std::istream &is, std::size_t blockSize = 65536);
+
+  bool nextRow();
+
+  std::size_t size() const;
+  const CSVField &operator[](std::size_t index) const;
+  const CSVField &at(std::size_t index) const;
+};
+
+#endif // CSVSCAN_H_
@@ -0,0 +1,317 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the implementation of the DecompressBuffer class. See
+  the header file for an overview of how it is used.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "decompress.h"
+
+#ifdef BETHYW_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef BETHYW_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+/*
+  Constructor for a DecompressBuffer, which starts decompressing straight
+  away on a thread of its own.
+
+  @param begin
+    A pointer to the first byte of the compressed data, which must outlive
+    the buffer
+
+  @param end
+    A pointer to one past the last byte of the compressed data
+
+  @param compression
+    The format of the compressed data (see detect())
+
+  @param blockSize
+    The size of each block of decompressed data
+
+  @param maxBlocks
+    The number of decompressed blocks that can be waiting to be read
+
+  @example
+    DecompressBuffer buffer(begin, end, DecompressBuffer::detect(begin, end));
+    std::istream is(&buffer);
+*/
+DecompressBuffer::DecompressBuffer(const char *begin,
+                                   const char *end,
+                                   Compression compression,
+                                   std::size_t blockSize,
+                                   std::size_t maxBlocks)
+    : input(begin), inputSize(end - begin), compression(compression),
+      blockSize(std::max<std::size_t>(blockSize, 1)),
+      maxBlocks(std::max<std::size_t>(maxBlocks, 1)),
+      finished(false), stopping(false){
+    worker = std::thread(&DecompressBuffer::run, this);
+}
+
+/*
+  Destructor for a DecompressBuffer, which stops the decompressing thread if
+  the data has not all been read, and waits for it.
+*/
+DecompressBuffer::~DecompressBuffer(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    worker.join();
+}
+
+/*
+  This function finds the format of a block of data from its magic bytes.
+
+  @param begin
+    A pointer to the first byte of the data
+
+  @param end
+    A pointer to one past the last byte of the data
+
+  @return
+    The format the data is compressed in, or Compression::None
+*/
+Compression DecompressBuffer::detect(const char *begin, const char *end){
+    static const unsigned char GZIP[] = {0x1f, 0x8b};
+    static const unsigned char ZSTD[] = {0x28, 0xb5, 0x2f, 0xfd};
+
+    std::size_t size = end - begin;
+    if (size >= sizeof(GZIP) && std::memcmp(begin, GZIP, sizeof(GZIP)) == 0) {
+        return Compression::Gzip;
+    } else if (size >= sizeof(ZSTD) && std::memcmp(begin, ZSTD, sizeof(ZSTD)) == 0) {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+/*
+  This function is run on the decompressing thread. It decompresses the data
+  into the queue of blocks, and then marks the buffer as finished, recording
+  the error if the data could not be decompressed.
+*/
+void DecompressBuffer::run(){
+    std::string message;
+    try {
+        if (compression == Compression::Gzip) {
+            inflateGzip();
+        } else if (compression == Compression::Zstd) {
+            decompressZstd();
+        } else {
+            std::vector<char> block(input, input + inputSize);
+            push(block, block.size());
+        }
+    } catch (const std::exception &e) {
+        message = e.what();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        error = message;
+    }
+    changed.notify_all();
+}
+
+/*
+  This function adds a block of decompressed data to the queue, first
+  waiting for there to be room in it.
+
+  @param block
+    The block, which is moved from (and should be replaced by a new block)
+
+  @param size
+    The number of bytes of the block that were decompressed into
+
+  @return
+    false if the reader has gone away, so decompressing should stop
+*/
+bool DecompressBuffer::push(std::vector<char> &block, std::size_t size){
+    if (size == 0) {
+        return true;
+    }
+    block.resize(size);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this]() {
+        return stopping || blocks.size() < maxBlocks;
+    });
+    if (stopping) {
+        return false;
+    }
+    blocks.push_back(std::move(block));
+    lock.unlock();
+    changed.notify_all();
+    return true;
+}
+
+/*
+  This function decompresses gzip data. A file may contain several gzip
+  members one after the other (as made by concatenating .gz files), which
+  are decompressed in turn.
+
+  @throws
+    std::runtime_error if the data is malformed or truncated, or the program
+    was built without zlib
+*/
+void DecompressBuffer::inflateGzip(){
+#ifdef BETHYW_HAVE_ZLIB
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    // 15 is the largest window size, and adding 16 only accepts gzip data
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+        throw std::runtime_error("DecompressBuffer: Failed to start decompressing gzip data");
+    }
+
+    std::size_t consumed = 0;
+    std::string message;
+    for (;;) {
+        // zlib counts input in unsigned ints, so a very large file is given
+        // to it a part at a time
+        if (stream.avail_in == 0 && consumed < inputSize) {
+            std::size_t part = std::min<std::size_t>(inputSize - consumed, UINT_MAX);
+            stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input + consumed));
+            stream.avail_in = static_cast<uInt>(part);
+            consumed += part;
+        }
+        bool inputLeft = stream.avail_in > 0 || consumed < inputSize;
+
+        std::vector<char> block(blockSize);
+        stream.next_out = reinterpret_cast<Bytef *>(block.data());
+        stream.avail_out = static_cast<uInt>(block.size());
+        int result = inflate(&stream, Z_NO_FLUSH);
+
+        if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+            message = std::string("DecompressBuffer: Malformed gzip data: ") +
+                      (stream.msg != nullptr ? stream.msg : "unknown error");
+            break;
+        }
+        if (!push(block, blockSize - stream.avail_out)) {
+            break;
+        }
+
+        if (result == Z_STREAM_END) {
+            if (stream.avail_in == 0 && consumed == inputSize) {
+                break;
+            }
+            inflateReset(&stream);
+        } else if (result == Z_BUF_ERROR && !inputLeft) {
+            message = "DecompressBuffer: Unexpected end of gzip data";
+            break;
+        }
+    }
+
+    inflateEnd(&stream);
+    if (!message.empty()) {
+        throw std::runtime_error(message);
+    }
+#else
+    throw std::runtime_error("DecompressBuffer: This program was built without gzip support");
+#endif
+}
+
+/*
+  This function decompresses zstd data, which may contain several frames one
+  after the other.
+
+  @throws
+    std::runtime_error if the data is malformed or truncated, or the program
+    was built without libzstd
+*/
+void DecompressBuffer::decompressZstd(){
+#ifdef BETHYW_HAVE_ZSTD
+    ZSTD_DStream *stream = ZSTD_createDStream();
+    if (stream == nullptr || ZSTD_isError(ZSTD_initDStream(stream))) {
+        ZSTD_freeDStream(stream);
+        throw std::runtime_error("DecompressBuffer: Failed to start decompressing zstd data");
+    }
+
+    ZSTD_inBuffer in = {input, inputSize, 0};
+    std::size_t result = 0;
+    std::string message;
+    for (;;) {
+        std::vector<char> block(blockSize);
+        ZSTD_outBuffer out = {block.data(), block.size(), 0};
+        result = ZSTD_decompressStream(stream, &out, &in);
+
+        if (ZSTD_isError(result)) {
+            message = std::string("DecompressBuffer: Malformed zstd data: ") + ZSTD_getErrorName(result);
+            break;
+        }
+        if (!push(block, out.pos)) {
+            break;
+        }
+
+        // Once all the input has been read, decompressing is finished when
+        // the last frame has been flushed (a result of 0), or the output is
+        // no longer filling whole blocks. Calling again after a frame ends
+        // exactly at the end of a block would start looking for another one
+        if (in.pos == in.size && (result == 0 || out.pos < out.size)) {
+            if (result != 0) {
+                message = "DecompressBuffer: Unexpected end of zstd data";
+            }
+            break;
+        }
+    }
+
+    ZSTD_freeDStream(stream);
+    if (!message.empty()) {
+        throw std::runtime_error(message);
+    }
+#else
+    throw std::runtime_error("DecompressBuffer: This program was built without zstd support");
+#endif
+}
+
+/*
+  This function is called by the stream when the block being read has been
+  read. It takes the next block from the queue, waiting for the decompressing
+  thread if need be.
+
+  @return
+    The next character, or EOF at the end of the data
+
+  @throws
+    std::runtime_error if the data could not be decompressed
+*/
+DecompressBuffer::int_type DecompressBuffer::underflow(){
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this]() {
+        return finished || !blocks.empty();
+    });
+    if (blocks.empty()) {
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+        return traits_type::eof();
+    }
+
+    current = std::move(blocks.front());
+    blocks.pop_front();
+    lock.unlock();
+    changed.notify_all();
+
+    setg(current.data(), current.data(), current.data() + current.size());
+    return traits_type::to_int_type(*gptr());
+}
@@ -0,0 +1,94 @@
+#ifndef DECOMPRESS_H_
+#define DECOMPRESS_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the declaration of the DecompressBuffer class, which
+  lets a compressed dataset be read through a std::istream as if it had been
+  decompressed to disk first.
+
+  gzip files are supported when the program is built with zlib
+  (BETHYW_HAVE_ZLIB), and zstd files when it is built with libzstd
+  (BETHYW_HAVE_ZSTD, which is off unless BETHYW_WITH_ZSTD is set). A file in a format that the build does not support
+  cannot be read, rather than being read as if it were not compressed.
+ */
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+  The formats a file can be compressed in, which are recognised by the magic
+  bytes at the start of the file rather than by its extension.
+*/
+enum class Compression { None, Gzip, Zstd };
+
+/*
+  A read-only stream buffer that decompresses a block of compressed memory
+  (e.g. a memory-mapped file).
+
+  The data is decompressed on a thread of its own, which runs ahead of the
+  reader by at most a few blocks: the blocks waiting to be read are held in a
+  bounded queue, and the thread waits whilst it is full. So decompressing and
+  parsing overlap, and no more than a few blocks of the decompressed data are
+  ever in memory at once.
+
+  If the compressed data is malformed, a std::runtime_error is thrown when
+  the reader gets to the point where it is malformed.
+*/
+class DecompressBuffer : public std::streambuf {
+private:
+  const char *input;
+  std::size_t inputSize;
+  Compression compression;
+  std::size_t blockSize;
+  std::size_t maxBlocks;
+
+  // The block being read
+  std::vector<char> current;
+
+  // Shared with the decompressing thread: the decompressed blocks waiting
+  // to be read, whether the thread has finished (and any error), and
+  // whether the reader has gone away
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::deque<std::vector<char>> blocks;
+  bool finished;
+  std::string error;
+  bool stopping;
+
+  std::thread worker;
+
+  void run();
+  void inflateGzip();
+  void decompressZstd();
+  bool push(std::vector<char> &block, std::size_t size);
+
+protected:
+  int_type underflow() override;
+
+public:
+  DecompressBuffer(const char *begin,
+                   const char *end,
+                   Compression compression,
+                   std::size_t blockSize = 256 * 1024,
+                   std::size_t maxBlocks = 4);
+  ~DecompressBuffer();
+
+  DecompressBuffer(const DecompressBuffer &other) = delete;
+  DecompressBuffer &operator=(const DecompressBuffer &other) = delete;
+
+  static Compression detect(const char *begin, const char *end);
+};
+
+#endif // DECOMPRESS_H_
@@ -17,9 +17,28 @@
   functions not specified.
  */
 
+#include <atomic>
 #include <iostream>
+#include <iterator>
 #include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#include <process.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define BETHYW_HAVE_MMAP
+#endif
+
 #include "input.h"
+#include "jsonscan.h"
 
 /*
   Constructor for an InputSource.
@@ -82,3 +101,470 @@ std::ifstream &InputFile::open(){
 
 }
 
+/*
+  Constructor for an empty MemoryBuffer.
+*/
+MemoryBuffer::MemoryBuffer() {
+
+}
+
+/*
+  Constructor for a MemoryBuffer over a block of memory, which must outlive
+  the buffer.
+
+  @param begin
+    A pointer to the first character
+
+  @param end
+    A pointer to one past the last character
+*/
+MemoryBuffer::MemoryBuffer(const char *begin, const char *end) {
+    assign(begin, end);
+}
+
+/*
+  This function changes the block of memory read through the buffer, which
+  must outlive the buffer.
+
+  @param begin
+    A pointer to the first character
+
+  @param end
+    A pointer to one past the last character
+*/
+void MemoryBuffer::assign(const char *begin, const char *end) {
+    // The buffer is never written to, so casting away const is safe
+    char *first = const_cast<char *>(begin);
+    setg(first, first, first + (end - begin));
+}
+
+/*
+  This function gets the characters that have not been read from the buffer
+  yet.
+
+  @return
+    A pointer to the next character to be read
+*/
+const char *MemoryBuffer::data() const {
+    return gptr();
+}
+
+/*
+  This function gets the number of characters that have not been read from
+  the buffer yet.
+
+  @return
+    The number of characters
+*/
+std::size_t MemoryBuffer::available() const {
+    return egptr() - gptr();
+}
+
+/*
+  This function marks characters as read, after they have been read in place
+  through data().
+
+  @param count
+    The number of characters, at most available()
+*/
+void MemoryBuffer::consume(std::size_t count) {
+    setg(eback(), gptr() + count, egptr());
+}
+
+/*
+  Constructor for a memory-mapped file-based source. The file is mapped (or
+  read) straight away, and any error opening it is reported by open().
+
+  @param filePath
+    The complete path for a file to import.
+
+  @example
+    InputMappedFile input("datasets/areas.csv");
+*/
+InputMappedFile::InputMappedFile(const std::string &filePath)
+    : InputSource(filePath), opened(false), mapping(nullptr), length(0),
+      compression(Compression::None), stream(&buffer) {
+
+#ifdef BETHYW_HAVE_MMAP
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat status;
+        if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode)) {
+            opened = true;
+            length = static_cast<std::size_t>(status.st_size);
+
+            // An empty file cannot be mapped, but does not need to be
+            if (length > 0) {
+                void *address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (address != MAP_FAILED) {
+                    mapping = address;
+                    madvise(mapping, length, MADV_SEQUENTIAL);
+                }
+            }
+        }
+        ::close(fd);
+
+        if (!opened || mapping != nullptr || length == 0) {
+            buffer.assign(data(), data() + size());
+            compression = DecompressBuffer::detect(data(), data() + size());
+            return;
+        }
+    }
+#endif
+
+    std::ifstream ifs(filePath, std::ios::binary);
+    if (ifs.is_open()) {
+        opened = true;
+        contents.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        length = contents.size();
+    }
+    buffer.assign(data(), data() + size());
+    compression = DecompressBuffer::detect(data(), data() + size());
+}
+
+/*
+  Destructor for a memory-mapped file-based source, which unmaps the file.
+*/
+InputMappedFile::~InputMappedFile() {
+    // The decompressing thread reads the mapped file, so it must be stopped
+    // before the file is unmapped
+    decompressor.reset();
+
+#ifdef BETHYW_HAVE_MMAP
+    if (mapping != nullptr) {
+        munmap(mapping, length);
+    }
+#endif
+}
+
+/*
+  This function returns a stream over the mapped file. If the file is
+  compressed, the stream reads it decompressed, and decompressing starts on
+  a thread of its own.
+
+  Any error decompressing the file is thrown as a std::runtime_error when the
+  stream is read.
+
+  @return
+    A standard input stream reference
+
+  @throws
+    std::runtime_error if there is an issue opening the file, with the same
+    message as InputFile::open():
+    InputFile::open: Failed to open file <file name>
+
+  @example
+    InputMappedFile input("datasets/areas.csv");
+    input.open();
+*/
+std::istream &InputMappedFile::open() {
+    if (!opened) {
+        throw std::runtime_error("InputFile::open: Failed to open file " + getSource());
+    }
+
+    if (compression != Compression::None && !decompressor) {
+        decompressor.reset(new DecompressBuffer(data(), data() + size(), compression));
+        stream.rdbuf(decompressor.get());
+        // Errors decompressing the file are thrown by the buffer, and are
+        // only passed on by the stream if it is set to throw them
+        stream.exceptions(std::ios::badbit);
+    }
+    return stream;
+}
+
+/*
+  This function gets the contents of the file as a block of memory, which is
+  valid for the lifetime of the InputMappedFile.
+
+  @return
+    A pointer to the first character of the file
+*/
+const char *InputMappedFile::data() const {
+    return mapping != nullptr ? static_cast<const char *>(mapping) : contents.data();
+}
+
+/*
+  This function gets the size of the file.
+
+  @return
+    The number of characters in the file
+*/
+std::size_t InputMappedFile::size() const {
+    return length;
+}
+
+/*
+  This function gets the format the file is compressed in, if any.
+
+  @return
+    The format, or Compression::None if the file is not compressed
+*/
+Compression InputMappedFile::getCompression() const {
+    return compression;
+}
+
+/*
+  This function asks the operating system to start reading a file into the
+  page cache in the background, so that it is already in memory (or on its
+  way) when it is opened later. It returns straight away, and does nothing if
+  the file cannot be opened or the hint is not supported.
+
+  @param filePath
+    The complete path for a file that will be imported
+
+  @example
+    InputMappedFile::prefetch("datasets/popu1009.json");
+    ...
+    InputMappedFile input("datasets/popu1009.json");
+*/
+void InputMappedFile::prefetch(const std::string &filePath) {
+#if defined(BETHYW_HAVE_MMAP) && defined(POSIX_FADV_WILLNEED)
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        ::close(fd);
+    }
+#else
+    (void) filePath;
+#endif
+}
+
+/*
+  Constructor for a paginated source.
+
+  @param filePath
+    The complete path of the file containing the first page
+
+  @param pagesDir
+    The directory containing the pages linked to from the first page,
+    including a trailing directory separator (e.g. "datasets/pages/")
+
+  @example
+    InputPages pages("datasets/envi0201.json", "datasets/pages/");
+*/
+InputPages::InputPages(const std::string &filePath, const std::string &pagesDir)
+    : InputSource(filePath), pagesDir(pagesDir), stream(&buffer) {
+
+}
+
+/*
+  Destructor for a paginated source, which waits for any page still being
+  read in the background.
+*/
+InputPages::~InputPages() {
+    if (nextPage.valid()) {
+        nextPage.wait();
+    }
+}
+
+/*
+  This function reads a page into memory, and finds the link to the page
+  after it.
+
+  @param path
+    The path of the page
+
+  @return
+    The page
+
+  @throws
+    std::runtime_error if there is an issue opening the file, with the message:
+    InputPages::open: Failed to open file <file name>
+*/
+InputPages::Page InputPages::readPage(const std::string &path) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) {
+        throw std::runtime_error("InputPages::open: Failed to open file " + path);
+    }
+
+    Page page;
+    page.path = path;
+    ifs.seekg(0, std::ios::end);
+    page.contents.resize(static_cast<std::size_t>(ifs.tellg()));
+    ifs.seekg(0, std::ios::beg);
+    ifs.read(&page.contents[0], page.contents.size());
+
+    // A malformed page has no link to follow; the error is reported when the
+    // page itself is imported
+    try {
+        JSONScanner scanner(page.contents.data(), page.contents.data() + page.contents.size());
+        scanner.findString("odata.nextLink", page.nextLink);
+    } catch (const std::runtime_error &e) {
+        page.nextLink.clear();
+    }
+    return page;
+}
+
+/*
+  This function starts reading the page linked to from the current page in
+  the background, unless it is the last page or the link has been followed
+  before.
+*/
+void InputPages::prefetch() {
+    if (page.nextLink.empty()) {
+        return;
+    }
+
+    std::string path = pagesDir + pageFileName(page.nextLink);
+    if (visited.find(path) != visited.end()) {
+        return;
+    }
+    nextPage = std::async(std::launch::async, readPage, path);
+}
+
+/*
+  This function makes a page the current page.
+
+  @param page
+    The page, which is moved from
+*/
+void InputPages::setPage(Page &&page) {
+    this->page = std::move(page);
+    visited.insert(this->page.path);
+
+    const char *data = this->page.contents.data();
+    buffer.assign(data, data + this->page.contents.size());
+    stream.clear();
+}
+
+/*
+  This function reads the first page and returns a stream over it. The page
+  after it starts being read in the background.
+
+  @return
+    A standard input stream reference
+
+  @throws
+    std::runtime_error if there is an issue opening the file, with the message:
+    InputPages::open: Failed to open file <file name>
+*/
+std::istream &InputPages::open() {
+    if (visited.empty()) {
+        setPage(readPage(getSource()));
+        prefetch();
+    }
+    return stream;
+}
+
+/*
+  This function moves the stream returned by open() on to the next page, and
+  starts reading the page after it in the background.
+
+  @return
+    true if there was a next page, false if the current page was the last
+
+  @throws
+    std::runtime_error if the next page could not be opened, with the message:
+    InputPages::open: Failed to open file <file name>
+*/
+bool InputPages::next() {
+    if (!nextPage.valid()) {
+        return false;
+    }
+
+    setPage(nextPage.get());
+    prefetch();
+    return true;
+}
+
+/*
+  This function gets the name of the file that holds a local copy of the page
+  at a link: the last segment of the link's path followed by its query, where
+  any character that is not a letter, digit, '.', '-' or '_' is replaced by
+  '_', with the extension .json.
+
+  @param link
+    The link to the page, e.g. an "odata.nextLink"
+
+  @return
+    The name of the file
+
+  @example
+    // "envi0201__24skiptoken_1000.json"
+    InputPages::pageFileName("http://open.statswales.gov.wales/en-gb/dataset/envi0201?%24skiptoken=1000");
+*/
+std::string InputPages::pageFileName(const std::string &link) {
+    std::string::size_type query = link.find('?');
+    std::string::size_type segment = link.rfind('/', query);
+    std::string name = segment == std::string::npos ? link : link.substr(segment + 1);
+
+    for (char &c : name) {
+        bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                    (c >= '0' && c <= '9') || c == '.' || c == '-' || c == '_';
+        if (!safe) {
+            c = '_';
+        }
+    }
+    return name + ".json";
+}
+
+/*
+  This function gets the path of a temporary file in the same directory as a
+  file, which is unique to this process (by its ID) and to this call (by a
+  counter), so that two runs of the program writing the same file at once
+  never write to the same temporary file. Renaming the temporary file to the
+  file then replaces it whole.
+
+  @param filePath
+    The path of the file that will be written
+
+  @return
+    The path of the temporary file
+
+  @example
+    // e.g. "datasets/.bethyw-catalog.json.tmp.4242.0"
+    std::string temporary = temporaryFilePath("datasets/.bethyw-catalog.json");
+*/
+std::string temporaryFilePath(const std::string &filePath){
+    static std::atomic<unsigned long> counter(0);
+#if defined(_WIN32)
+    unsigned long process = static_cast<unsigned long>(_getpid());
+#elif defined(__unix__) || defined(__APPLE__)
+    unsigned long process = static_cast<unsigned long>(getpid());
+#else
+    unsigned long process = 0;
+#endif
+    return filePath + ".tmp." + std::to_string(process) + "." + std::to_string(counter++);
+}
+
+/*
+  This function finds the size, modification time and inode of a file. The
+  modification time is to the nanosecond where the file system records it,
+  as a time in whole seconds does not change when a file is rewritten within
+  the same second; the inode changes when a file is replaced by another
+  (e.g. by renaming a new copy over it).
+
+  @param filePath
+    The path of the file
+
+  @param size
+    Set to the size of the file, in bytes
+
+  @param modified
+    Set to the time the file was last modified, in nanoseconds
+
+  @param inode
+    Set to the inode of the file (0 where there are none)
+
+  @return
+    false if the file does not exist, true otherwise
+*/
+bool fileStatus(const std::string &filePath, long long &size, long long &modified,
+                unsigned long long &inode){
+    struct stat status;
+    if (stat(filePath.c_str(), &status) != 0) {
+        return false;
+    }
+    size = static_cast<long long>(status.st_size);
+#if defined(__APPLE__)
+    modified = static_cast<long long>(status.st_mtimespec.tv_sec) * 1000000000LL +
+               status.st_mtimespec.tv_nsec;
+#elif defined(__unix__)
+    modified = static_cast<long long>(status.st_mtim.tv_sec) * 1000000000LL +
+               status.st_mtim.tv_nsec;
+#else
+    modified = static_cast<long long>(status.st_mtime) * 1000000000LL;
+#endif
+    inode = static_cast<unsigned long long>(status.st_ino);
+    return true;
+}
@@ -11,7 +11,9 @@
   This file contains declarations for the input source handlers. There are
   two classes: InputSource and InputFile. InputSource is abstract (i.e. it
   contains a pure virtual function). InputFile is a concrete derivation of
-  InputSource, for input from files.
+  InputSource, for input from files, and InputMappedFile is a memory-mapped
+  variant of it. InputPages is another, for datasets that are split into
+  pages which link to each other.
 
   Although only one class derives from InputSource, we have implemented our
   code this way to support future expansion of input from different sources
@@ -21,8 +23,16 @@
   functions and member variables you need to declare in these classes.
  */
 
+#include <cstddef>
 #include <string>
 #include <fstream>
+#include <future>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <unordered_set>
+
+#include "decompress.h"
 
 /*
   InputSource is an abstract/purely virtual base class for all input source 
@@ -61,4 +71,143 @@ public:
   std::ifstream &open();
 };
 
+/*
+  A read-only stream buffer over a block of memory, so that data which has
+  already been read into memory can be read through a std::istream without
+  being copied again.
+*/
+class MemoryBuffer : public std::streambuf {
+public:
+  MemoryBuffer();
+  MemoryBuffer(const char *begin, const char *end);
+
+  void assign(const char *begin, const char *end);
+
+  // The characters that have not been read yet, so that a parser can read
+  // them in place and then consume() them
+  const char *data() const;
+  std::size_t available() const;
+  void consume(std::size_t count);
+};
+
+/*
+  Source data that is contained within a file, which is memory-mapped rather
+  than read through a std::ifstream. The whole file can be read in place as a
+  contiguous block of memory with data() and size(), and the stream returned
+  by open() reads it through a MemoryBuffer for the parsers that need a
+  std::istream.
+
+  The file is mapped for sequential access, so the operating system reads
+  ahead of the parser, and the page cache is used directly on repeated runs.
+  Where memory-mapping is not available (or fails), the file is read into
+  memory instead.
+
+  A file compressed with gzip or zstd is recognised by its magic bytes, and
+  the stream returned by open() reads it decompressed, through a
+  DecompressBuffer that decompresses it on a thread of its own. data() and
+  size() always give the file as it is stored.
+
+    InputMappedFile input("datasets/popu1009.json");
+    std::istream &is = input.open();
+*/
+class InputMappedFile : public InputSource {
+private:
+  bool opened;
+
+  // The mapped file, or nullptr if it was read into contents instead
+  void *mapping;
+  std::size_t length;
+  std::string contents;
+
+  MemoryBuffer buffer;
+  Compression compression;
+  std::unique_ptr<DecompressBuffer> decompressor;
+  std::istream stream;
+
+public:
+  InputMappedFile(const std::string &filePath);
+  ~InputMappedFile();
+
+  InputMappedFile(const InputMappedFile &other) = delete;
+  InputMappedFile &operator=(const InputMappedFile &other) = delete;
+
+  std::istream &open();
+
+  const char *data() const;
+  std::size_t size() const;
+  Compression getCompression() const;
+
+  static void prefetch(const std::string &filePath);
+};
+
+/*
+  Source data that is split into pages, as returned by the StatsWales OData
+  API: each page is a StatsWales JSON file, and all but the last contain an
+  "odata.nextLink" with the URL of the next page.
+
+  The pages are read from a local copy of the API: the page at a link is the
+  file in pagesDir named by pageFileName(). Whilst one page is being
+  imported, the next is read into memory on a background thread.
+
+  The stream returned by open() reads the first page, and next() moves it on
+  to the next page, e.g.
+
+    InputPages pages("datasets/envi0201.json", "datasets/pages/");
+    std::istream &is = pages.open();
+    do {
+      ... read is ...
+    } while (pages.next());
+*/
+class InputPages : public InputSource {
+private:
+  // A page read into memory, and the link to the page after it (or an empty
+  // string if it is the last page)
+  struct Page {
+    std::string path;
+    std::string contents;
+    std::string nextLink;
+  };
+
+  std::string pagesDir;
+
+  // The page being read, and a stream over it
+  Page page;
+  MemoryBuffer buffer;
+  std::istream stream;
+
+  // The next page, being read in the background
+  std::future<Page> nextPage;
+
+  // The paths of the pages read so far, so that a chain of links that loops
+  // back on itself is only followed once
+  std::unordered_set<std::string> visited;
+
+  static Page readPage(const std::string &path);
+  void prefetch();
+  void setPage(Page &&page);
+
+public:
+  InputPages(const std::string &filePath, const std::string &pagesDir);
+  ~InputPages();
+
+  std::istream &open();
+  bool next();
+
+  static std::string pageFileName(const std::string &link);
+};
+
+/*
+  The path of a temporary file next to filePath that no other thread or run
+  of the program uses, for writing a file that is then renamed to filePath.
+*/
+std::string temporaryFilePath(const std::string &filePath);
+
+/*
+  The size, modification time (in nanoseconds) and inode of a file, which
+  a cache of something read from the file (a DatasetSummary, or the sidecar
+  file of a RecordIndex) is checked against, with a hash of its contents.
+*/
+bool fileStatus(const std::string &filePath, long long &size, long long &modified,
+                unsigned long long &inode);
+
 #endif // INPUT_H_
\ No newline at end of file
@@ -0,0 +1,545 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the implementation of the JSONIndexScanner class. See
+  the header file for an overview of the two stages of scanning.
+*/
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "jsonindex.h"
+#include "jsonscan.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BETHYW_HAVE_SSE2
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BETHYW_HAVE_AVX2
+#endif
+
+/*
+  Bitmasks for a 64-byte block of the input, where bit i is set if byte i of
+  the block is a quote, a backslash, or one of the operators {}[]:,
+*/
+struct BlockMasks {
+    std::uint64_t quote;
+    std::uint64_t backslash;
+    std::uint64_t op;
+};
+
+/*
+  Classify a 64-byte block one byte at a time, for CPUs without SIMD support.
+*/
+static BlockMasks classifyScalar(const char *block){
+    BlockMasks masks = {0, 0, 0};
+    for (int i = 0; i < 64; i++) {
+        std::uint64_t bit = std::uint64_t(1) << i;
+        switch (block[i]) {
+            case '"':
+                masks.quote |= bit;
+                break;
+            case '\\':
+                masks.backslash |= bit;
+                break;
+            case '{': case '}': case '[': case ']': case ':': case ',':
+                masks.op |= bit;
+                break;
+        }
+    }
+    return masks;
+}
+
+#ifdef BETHYW_HAVE_SSE2
+/*
+  Classify a 64-byte block 16 bytes at a time with SSE2. Brackets and braces
+  only differ by the 0x20 bit ('[' is 0x5B and '{' is 0x7B), so they are
+  matched with two comparisons after setting that bit.
+*/
+static BlockMasks classifySSE2(const char *block){
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i lowercase = _mm_set1_epi8(0x20);
+    const __m128i open = _mm_set1_epi8('{');
+    const __m128i close = _mm_set1_epi8('}');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+
+    BlockMasks masks = {0, 0, 0};
+    for (int i = 0; i < 4; i++) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * i));
+        __m128i folded = _mm_or_si128(v, lowercase);
+        __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, open),
+                                               _mm_cmpeq_epi8(folded, close)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, colon),
+                                               _mm_cmpeq_epi8(v, comma)));
+
+        int shift = 16 * i;
+        masks.quote |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+        masks.backslash |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)))) << shift;
+        masks.op |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(op))) << shift;
+    }
+    return masks;
+}
+#endif
+
+#ifdef BETHYW_HAVE_AVX2
+/*
+  Classify a 64-byte block 32 bytes at a time with AVX2. This is only called
+  if the CPU supports AVX2 (see implementation()).
+*/
+__attribute__((target("avx2")))
+static BlockMasks classifyAVX2(const char *block){
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i lowercase = _mm256_set1_epi8(0x20);
+    const __m256i open = _mm256_set1_epi8('{');
+    const __m256i close = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+
+    BlockMasks masks = {0, 0, 0};
+    for (int i = 0; i < 2; i++) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32 * i));
+        __m256i folded = _mm256_or_si256(v, lowercase);
+        __m256i op = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(folded, open),
+                                                     _mm256_cmpeq_epi8(folded, close)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(v, colon),
+                                                     _mm256_cmpeq_epi8(v, comma)));
+
+        int shift = 32 * i;
+        masks.quote |= std::uint64_t(std::uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)))) << shift;
+        masks.backslash |= std::uint64_t(std::uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash)))) << shift;
+        masks.op |= std::uint64_t(std::uint32_t(_mm256_movemask_epi8(op))) << shift;
+    }
+    return masks;
+}
+#endif
+
+using Classifier = BlockMasks (*)(const char *);
+
+/*
+  Choose the fastest classifier supported by the CPU we are running on.
+*/
+static Classifier selectClassifier(){
+#ifdef BETHYW_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return classifyAVX2;
+    }
+#endif
+#ifdef BETHYW_HAVE_SSE2
+    return classifySSE2;
+#else
+    return classifyScalar;
+#endif
+}
+
+static Classifier classify = selectClassifier();
+
+/*
+  Returns the index of the lowest set bit of x, which must not be 0.
+*/
+static inline int lowestBit(std::uint64_t x){
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int i = 0;
+    while ((x & 1) == 0) {
+        x >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+/*
+  Returns a mask where bit i is the XOR of bits 0 to i of x. Applied to the
+  positions of quotes, this gives the bytes that are inside strings.
+*/
+static inline std::uint64_t prefixXor(std::uint64_t x){
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+/*
+  Returns a mask of the bytes in a block that are escaped by a backslash.
+
+  @param backslash
+    The backslashes in the block
+
+  @param carry
+    Whether the first byte of the block is escaped by a backslash at the end
+    of the previous block; updated for the next block
+*/
+static std::uint64_t escapedBytes(std::uint64_t backslash, bool &carry){
+    std::uint64_t escaped = carry ? 1 : 0;
+    carry = false;
+
+    while (backslash != 0) {
+        int i = lowestBit(backslash);
+        backslash &= backslash - 1;
+        if ((escaped >> i) & 1) {
+            continue;
+        }
+        if (i == 63) {
+            carry = true;
+        } else {
+            escaped |= std::uint64_t(1) << (i + 1);
+        }
+    }
+    return escaped;
+}
+
+/*
+  Construct a JSONIndexScanner for a document in memory and build its
+  structural index. The memory must outlive the scanner.
+
+  @param begin
+    A pointer to the first character of the document
+
+  @param end
+    A pointer to one past the last character of the document
+
+  @throws
+    std::runtime_error if the document contains an unterminated string, or is
+    too large to be indexed
+*/
+JSONIndexScanner::JSONIndexScanner(const char *begin, const char *end)
+    : data(begin), size(end - begin), next(0){
+    buildIndex();
+}
+
+/*
+  This function builds the structural index of the document (stage 1).
+*/
+void JSONIndexScanner::buildIndex(){
+    if (size > std::numeric_limits<std::uint32_t>::max()) {
+        error("document is too large to index");
+    }
+    positions.reserve(size / 8);
+
+    std::uint64_t inStringCarry = 0;
+    bool escapeCarry = false;
+    char tail[64];
+
+    for (std::size_t base = 0; base < size; base += 64) {
+        const char *block = data + base;
+        if (size - base < 64) {
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, block, size - base);
+            block = tail;
+        }
+
+        BlockMasks masks = classify(block);
+
+        std::uint64_t quotes = masks.quote;
+        if (masks.backslash != 0 || escapeCarry) {
+            quotes &= ~escapedBytes(masks.backslash, escapeCarry);
+        }
+
+        std::uint64_t inString = prefixXor(quotes) ^ inStringCarry;
+        inStringCarry = std::uint64_t(0) - (inString >> 63);
+
+        std::uint64_t structural = (masks.op & ~inString) | quotes;
+        while (structural != 0) {
+            positions.push_back(static_cast<std::uint32_t>(base + lowestBit(structural)));
+            structural &= structural - 1;
+        }    }
+
+    if (inStringCarry != 0) {
+        error("unterminated string");
+    }
+}
+
+/*
+  This function gets the structural character at an index.
+
+  @param index
+    The index into positions
+
+  @return
+    The character, or '\0' if index is past the end of the index
+*/
+char JSONIndexScanner::at(std::size_t index) const{
+    return index < positions.size() ? data[positions[index]] : '\0';
+}
+
+/*
+  This function consumes the next structural character, which must be c.
+*/
+void JSONIndexScanner::expect(char c){
+    if (at(next) != c) {
+        error(std::string("expected '") + c + "'");
+    }
+    next++;
+}
+
+/*
+  This function reads the string whose opening quote is the next structural
+  character, decoding it if it contains escape sequences.
+
+  @param out
+    The string to store the string in
+*/
+void JSONIndexScanner::readString(std::string &out){
+    if (at(next) != '"' || at(next + 1) != '"') {
+        error("expected a string");
+    }
+    const char *open = data + positions[next];
+    const char *close = data + positions[next + 1];
+    next += 2;
+
+    if (std::memchr(open + 1, '\\', close - open - 1) == nullptr) {
+        out.assign(open + 1, close);
+    } else {
+        JSONScanner scanner(open, close + 1);
+        scanner.readValue(out);
+    }
+}
+
+/*
+  This function skips forward until `depth` objects or arrays have been
+  closed, using only the structural index.
+
+  @param depth
+    The number of open containers to skip out of
+*/
+void JSONIndexScanner::skipToClose(unsigned int depth){
+    while (depth > 0) {
+        if (next >= positions.size()) {
+            error("unexpected end of input");
+        }
+        char c = data[positions[next++]];
+        if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            depth--;
+        }
+    }
+}
+
+/*
+  This function throws a std::runtime_error, including the byte offset at
+  which the error occurred.
+*/
+void JSONIndexScanner::error(const std::string &message) const{
+    throw std::runtime_error("JSONIndexScanner: " + message + " at byte " +
+                             std::to_string(offset()));
+}
+
+/*
+  This function searches the members of the top-level object for the key
+  `key` whose value is an array, and moves the scanner inside it, ready for
+  nextObject() to be called.
+
+  @param key
+    The key of the array
+
+  @return
+    true if the array was found, false otherwise
+*/
+bool JSONIndexScanner::findArray(const std::string &key){
+    expect('{');
+
+    std::string name;
+    while (nextKey(name)) {
+        if (name == key && at(next) == '[') {
+            next++;
+            return true;
+        }
+        skipValue();
+    }
+    return false;
+}
+
+/*
+  This function moves the scanner into the next object of the current array,
+  ready for nextKey() to be called.
+
+  @return
+    true if the scanner is inside the next object, false if the end of the
+    array (or input) has been reached
+*/
+bool JSONIndexScanner::nextObject(){
+    char c = at(next);
+    if (c == ',') {
+        c = at(++next);
+    }
+
+    if (c == '{') {
+        next++;
+        return true;
+    } else if (c == ']') {
+        next++;
+        return false;
+    } else if (c == '\0') {
+        return false;
+    }
+    error("expected an object");
+}
+
+/*
+  This function reads the next key of the current object, and moves the
+  scanner to its value, which must then be read with readValue() or skipped
+  with skipValue().
+
+  @param key
+    The string to store the key in
+
+  @return
+    true if a key was read, false if the end of the object was reached
+*/
+bool JSONIndexScanner::nextKey(std::string &key){
+    char c = at(next);
+    if (c == ',') {
+        next++;
+    } else if (c == '}') {
+        next++;
+        return false;
+    }
+
+    if (at(next) != '"') {
+        error("expected a key");
+    }
+    readString(key);
+    expect(':');
+    return true;
+}
+
+/*
+  This function reads a scalar value. Strings are decoded, while numbers and
+  the literals true, false and null are returned as their raw text.
+
+  Numbers and literals do not appear in the structural index, so their text is
+  everything between the colon before them and the next structural character.
+
+  @param out
+    The string to store the value in
+
+  @return
+    true if the value was a string, false otherwise
+*/
+bool JSONIndexScanner::readValue(std::string &out){
+    char c = at(next);
+    if (c == '"') {
+        readString(out);
+        return true;
+    } else if (c == '{' || c == '[') {
+        error("expected a scalar value");
+    }
+
+    const char *begin = data + positions[next - 1] + 1;
+    const char *end = next < positions.size() ? data + positions[next] : data + size;
+    while (begin != end && std::strchr(" \t\r\n", *begin) != nullptr) {
+        begin++;
+    }
+    while (end != begin && std::strchr(" \t\r\n", *(end - 1)) != nullptr) {
+        end--;
+    }
+    if (begin == end) {
+        error("expected a value");
+    }
+    out.assign(begin, end);
+    return false;
+}
+
+/*
+  This function skips a value of any type by jumping over its entries in the
+  structural index.
+*/
+void JSONIndexScanner::skipValue(){
+    char c = at(next);
+    if (c == '"') {
+        next += 2;
+    } else if (c == '{' || c == '[') {
+        next++;
+        skipToClose(1);
+    }
+}
+
+/*
+  This function skips the remaining members of the current object, including
+  its closing brace.
+*/
+void JSONIndexScanner::skipObject(){
+    skipToClose(1);
+}
+
+/*
+  This function gets the offset of the scanner from the start of the document.
+
+  @return
+    The offset of the next structural character
+*/
+std::size_t JSONIndexScanner::offset() const{
+    return next < positions.size() ? positions[next] : size;
+}
+
+/*
+  This function gets the name of the instruction set used to build the
+  structural index. By default this is the fastest supported by the CPU.
+
+  @return
+    "AVX2", "SSE2" or "scalar"
+*/
+const char *JSONIndexScanner::implementation(){
+#ifdef BETHYW_HAVE_AVX2
+    if (classify == classifyAVX2) {
+        return "AVX2";
+    }
+#endif
+#ifdef BETHYW_HAVE_SSE2
+    if (classify == classifySSE2) {
+        return "SSE2";
+    }
+#endif
+    return "scalar";
+}
+
+/*
+  This function changes the instruction set used to build the structural
+  index, e.g. to compare the SIMD implementations against the scalar one.
+
+  @param name
+    "AVX2", "SSE2" or "scalar"
+
+  @return
+    true if the instruction set is supported by this build and CPU, false
+    otherwise (in which case the implementation is unchanged)
+*/
+bool JSONIndexScanner::setImplementation(const std::string &name){
+    if (name == "scalar") {
+        classify = classifyScalar;
+        return true;
+    }
+#ifdef BETHYW_HAVE_SSE2
+    if (name == "SSE2") {
+        classify = classifySSE2;
+        return true;
+    }
+#endif
+#ifdef BETHYW_HAVE_AVX2
+    if (name == "AVX2" && __builtin_cpu_supports("avx2")) {
+        classify = classifyAVX2;
+        return true;
+    }
+#endif
+    return false;
+}
@@ -0,0 +1,68 @@
+#ifndef JSONINDEX_H_
+#define JSONINDEX_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the declaration of the JSONIndexScanner class, a JSON
+  tokenizer for documents held in memory that works in two stages:
+
+  1. A structural index is built: the position of every quote, brace,
+     bracket, colon and comma that is not inside a string. The input is
+     classified 64 bytes at a time using AVX2 or SSE2 instructions where the
+     CPU supports them (with a scalar fallback elsewhere).
+
+  2. The document is walked using the index, so that strings and whole
+     objects can be stepped over by jumping between indexed positions,
+     without looking at the characters in between.
+
+  JSONIndexScanner has the same interface as JSONScanner (see jsonscan.h), so
+  either can be used to read StatsWales JSON files.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class JSONIndexScanner {
+private:
+  // The document being scanned
+  const char *data;
+  std::size_t size;
+
+  // The positions of the structural characters and quotes in the document
+  std::vector<std::uint32_t> positions;
+
+  // The index in positions of the next structural character to read
+  std::size_t next;
+
+  void buildIndex();
+  char at(std::size_t index) const;
+  void expect(char c);
+  void readString(std::string &out);
+  void skipToClose(unsigned int depth);
+
+  [[noreturn]] void error(const std::string &message) const;
+
+public:
+  JSONIndexScanner(const char *begin, const char *end);
+
+  bool findArray(const std::string &key);
+  bool nextObject();
+  bool nextKey(std::string &key);
+  bool readValue(std::string &out);
+  void skipValue();
+  void skipObject();
+
+  std::size_t offset() const;
+
+  static const char *implementation();
+  static bool setImplementation(const std::string &name);
+};
+
+#endif // JSONINDEX_H_
@@ -0,0 +1,504 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the implementation of the JSONScanner class. See the
+  header file for an overview of how the scanner is used.
+*/
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+#include "jsonscan.h"
+
+/*
+  Construct a JSONScanner that reads from a standard input stream, one block
+  at a time.
+
+  @param is
+    The input stream to read
+
+  @param blockSize
+    The number of bytes to read from the stream at once
+
+  @example
+    std::ifstream is("datasets/popu1009.json");
+    JSONScanner scanner(is);
+*/
+JSONScanner::JSONScanner(std::istream &is, std::size_t blockSize)
+    : is(&is), buffer(blockSize), begin(nullptr), cur(nullptr), end(nullptr),
+      consumed(0){
+
+}
+
+/*
+  Construct a JSONScanner that reads from a contiguous block of memory. The
+  memory must outlive the scanner.
+
+  @param begin
+    A pointer to the first character to scan
+
+  @param end
+    A pointer to one past the last character to scan
+*/
+JSONScanner::JSONScanner(const char *begin, const char *end)
+    : is(nullptr), begin(begin), cur(begin), end(end), consumed(0){
+
+}
+
+/*
+  This function reads the next block of the input stream into the buffer.
+
+  @return
+    true if more input was read, false at the end of the input
+*/
+bool JSONScanner::fill(){
+    if (is == nullptr || !is->good()) {
+        return false;
+    }
+
+    consumed += end - begin;
+    is->read(buffer.data(), buffer.size());
+    std::streamsize read = is->gcount();
+
+    begin = buffer.data();
+    cur = begin;
+    end = begin + read;
+    return read > 0;
+}
+
+/*
+  This function returns the next character without consuming it.
+
+  @return
+    The next character, or EOF at the end of the input
+*/
+int JSONScanner::peek(){
+    if (cur == end && !fill()) {
+        return EOF;
+    }
+    return static_cast<unsigned char>(*cur);
+}
+
+/*
+  This function consumes and returns the next character.
+
+  @return
+    The next character
+
+  @throws
+    std::runtime_error if the end of the input has been reached
+*/
+char JSONScanner::get(){
+    if (cur == end && !fill()) {
+        error("unexpected end of input");
+    }
+    return *cur++;
+}
+
+/*
+  This function consumes the next character, which must be c.
+
+  @param c
+    The expected character
+
+  @throws
+    std::runtime_error if the next character is not c
+*/
+void JSONScanner::expect(char c){
+    if (get() != c) {
+        error(std::string("expected '") + c + "'");
+    }
+}
+
+/*
+  This function skips over any whitespace.
+*/
+void JSONScanner::skipWhitespace(){
+    for (;;) {
+        while (cur != end) {
+            char c = *cur;
+            if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+                return;
+            }
+            cur++;
+        }
+        if (!fill()) {
+            return;
+        }
+    }
+}
+
+/*
+  This function skips the rest of a string whose opening quote has already
+  been consumed, without decoding it.
+*/
+void JSONScanner::skipString(){
+    for (;;) {
+        while (cur != end) {
+            char c = *cur++;
+            if (c == '"') {
+                return;
+            } else if (c == '\\') {
+                get();
+            }
+        }
+        if (!fill()) {
+            error("unterminated string");
+        }
+    }
+}
+
+/*
+  This function reads the rest of a string whose opening quote has already
+  been consumed, decoding any escape sequences into UTF-8.
+
+  @param out
+    The string to append the decoded characters to
+*/
+void JSONScanner::readString(std::string &out){
+    for (;;) {
+        const char *run = cur;
+        while (cur != end && *cur != '"' && *cur != '\\') {
+            cur++;
+        }
+        out.append(run, cur);
+
+        if (cur == end) {
+            if (!fill()) {
+                error("unterminated string");
+            }
+            continue;
+        }
+
+        if (*cur++ == '"') {
+            return;
+        }
+
+        char escaped = get();
+        switch (escaped) {
+            case '"':  out += '"';  break;
+            case '\\': out += '\\'; break;
+            case '/':  out += '/';  break;
+            case 'b':  out += '\b'; break;
+            case 'f':  out += '\f'; break;
+            case 'n':  out += '\n'; break;
+            case 'r':  out += '\r'; break;
+            case 't':  out += '\t'; break;
+            case 'u': {
+                auto hex = [this]() {
+                    unsigned int value = 0;
+                    for (int i = 0; i < 4; i++) {
+                        char c = get();
+                        value <<= 4;
+                        if (c >= '0' && c <= '9') {
+                            value |= c - '0';
+                        } else if (c >= 'a' && c <= 'f') {
+                            value |= c - 'a' + 10;
+                        } else if (c >= 'A' && c <= 'F') {
+                            value |= c - 'A' + 10;
+                        } else {
+                            error("invalid \\u escape");
+                        }
+                    }
+                    return value;
+                };
+
+                unsigned int codePoint = hex();
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                    expect('\\');
+                    expect('u');
+                    unsigned int low = hex();
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        error("invalid surrogate pair");
+                    }
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+
+                if (codePoint < 0x80) {
+                    out += static_cast<char>(codePoint);
+                } else if (codePoint < 0x800) {
+                    out += static_cast<char>(0xC0 | (codePoint >> 6));
+                    out += static_cast<char>(0x80 | (codePoint & 0x3F));
+                } else if (codePoint < 0x10000) {
+                    out += static_cast<char>(0xE0 | (codePoint >> 12));
+                    out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (codePoint & 0x3F));
+                } else {
+                    out += static_cast<char>(0xF0 | (codePoint >> 18));
+                    out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (codePoint & 0x3F));
+                }
+                break;
+            }
+            default:
+                error("invalid escape sequence");
+        }
+    }
+}
+
+/*
+  Returns true if c ends a number or literal (true, false, null).
+*/
+static bool endsLiteral(int c){
+    return c == EOF || c == ',' || c == '}' || c == ']' ||
+           c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/*
+  This function reads the raw text of a number or literal.
+
+  @param out
+    The string to append the text to
+*/
+void JSONScanner::readLiteral(std::string &out){
+    std::size_t length = out.size();
+    while (!endsLiteral(peek())) {
+        out += *cur++;
+    }
+    if (out.size() == length) {
+        error("expected a value");
+    }
+}
+
+/*
+  This function skips a number or literal.
+*/
+void JSONScanner::skipLiteral(){
+    if (endsLiteral(peek())) {
+        error("expected a value");
+    }
+    while (!endsLiteral(peek())) {
+        cur++;
+    }
+}
+
+/*
+  This function skips forward until `depth` objects or arrays have been
+  closed, i.e. past the end of the containers that are currently open.
+
+  @param depth
+    The number of open containers to skip out of
+*/
+void JSONScanner::skipToClose(unsigned int depth){
+    while (depth > 0) {
+        while (cur != end) {
+            char c = *cur++;
+            if (c == '"') {
+                skipString();
+            } else if (c == '{' || c == '[') {
+                depth++;
+            } else if ((c == '}' || c == ']') && --depth == 0) {
+                return;
+            }
+        }
+        if (!fill()) {
+            error("unexpected end of input");
+        }
+    }
+}
+
+/*
+  This function throws a std::runtime_error, including the byte offset at
+  which the error occurred.
+
+  @param message
+    A description of the error
+
+  @throws
+    std::runtime_error always
+*/
+void JSONScanner::error(const std::string &message) const{
+    throw std::runtime_error("JSONScanner: " + message + " at byte " +
+                             std::to_string(offset()));
+}
+
+/*
+  This function searches the members of the top-level object for the key
+  `key` whose value is an array, and moves the scanner inside it, ready for
+  nextObject() to be called.
+
+  @param key
+    The key of the array
+
+  @return
+    true if the array was found, false otherwise
+*/
+bool JSONScanner::findArray(const std::string &key){
+    skipWhitespace();
+    expect('{');
+
+    std::string name;
+    while (nextKey(name)) {
+        if (name == key) {
+            skipWhitespace();
+            if (peek() == '[') {
+                cur++;
+                return true;
+            }
+        }
+        skipValue();
+    }
+    return false;
+}
+
+/*
+  This function searches the members of the top-level object for the key
+  `key` whose value is a string, and reads the string.
+
+  @param key
+    The key of the string
+
+  @param value
+    The string to store the value in
+
+  @return
+    true if the string was found, false otherwise
+*/
+bool JSONScanner::findString(const std::string &key, std::string &value){
+    skipWhitespace();
+    expect('{');
+
+    std::string name;
+    while (nextKey(name)) {
+        if (name == key) {
+            skipWhitespace();
+            if (peek() == '"') {
+                return readValue(value);
+            }
+        }
+        skipValue();
+    }
+    return false;
+}
+
+/*
+  This function moves the scanner into the next object of the current array,
+  ready for nextKey() to be called.
+
+  @return
+    true if the scanner is inside the next object, false if the end of the
+    array (or input) has been reached
+*/
+bool JSONScanner::nextObject(){
+    skipWhitespace();
+    int c = peek();
+    if (c == ',') {
+        cur++;
+        skipWhitespace();
+        c = peek();
+    }
+
+    if (c == '{') {
+        cur++;
+        return true;
+    } else if (c == ']') {
+        cur++;
+        return false;
+    } else if (c == EOF) {
+        return false;
+    }
+    error("expected an object");
+}
+
+/*
+  This function reads the next key of the current object, and moves the
+  scanner to its value, which must then be read with readValue() or skipped
+  with skipValue().
+
+  @param key
+    The string to store the key in
+
+  @return
+    true if a key was read, false if the end of the object was reached
+*/
+bool JSONScanner::nextKey(std::string &key){
+    skipWhitespace();
+    char c = get();
+    if (c == ',') {
+        skipWhitespace();
+        c = get();
+    } else if (c == '}') {
+        return false;
+    }
+
+    if (c != '"') {
+        error("expected a key");
+    }
+    key.clear();
+    readString(key);
+
+    skipWhitespace();
+    expect(':');
+    return true;
+}
+
+/*
+  This function reads a scalar value. Strings are decoded, while numbers and
+  the literals true, false and null are returned as their raw text.
+
+  @param out
+    The string to store the value in
+
+  @return
+    true if the value was a string, false otherwise
+*/
+bool JSONScanner::readValue(std::string &out){
+    skipWhitespace();
+    out.clear();
+
+    int c = peek();
+    if (c == '"') {
+        cur++;
+        readString(out);
+        return true;
+    } else if (c == '{' || c == '[') {
+        error("expected a scalar value");
+    }
+    readLiteral(out);
+    return false;
+}
+
+/*
+  This function skips a value of any type without decoding it.
+*/
+void JSONScanner::skipValue(){
+    skipWhitespace();
+
+    int c = peek();
+    if (c == '"') {
+        cur++;
+        skipString();
+    } else if (c == '{' || c == '[') {
+        cur++;
+        skipToClose(1);
+    } else {
+        skipLiteral();
+    }
+}
+
+/*
+  This function skips the remaining members of the current object, including
+  its closing brace.
+*/
+void JSONScanner::skipObject(){
+    skipToClose(1);
+}
+
+/*
+  This function gets the offset of the scanner from the start of the input.
+
+  @return
+    The number of bytes consumed so far
+*/
+std::size_t JSONScanner::offset() const{
+    return consumed + (cur - begin);
+}
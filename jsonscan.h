@@ -0,0 +1,89 @@
+#ifndef JSONSCAN_H_
+#define JSONSCAN_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the declaration of the JSONScanner class, a small
+  pull-based JSON tokenizer used to import StatsWales JSON files.
+
+  Unlike the nlohmann JSON library, which decodes every value of a document,
+  JSONScanner lets the caller decide value by value whether it should be read
+  or skipped. Skipped values are stepped over without being decoded or copied,
+  which makes it well suited for reading only a few columns from each record.
+ */
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+/*
+  JSONScanner reads JSON either from a standard input stream, which it reads
+  in fixed-size blocks so that memory use is independent of the size of the
+  input, or from a contiguous block of memory.
+
+  The scanner is driven by the caller, e.g. to read every key and value of
+  the objects within the array "value":
+
+    JSONScanner scanner(is);
+    if (scanner.findArray("value")) {
+      while (scanner.nextObject()) {
+        while (scanner.nextKey(key)) {
+          scanner.readValue(value);
+        }
+      }
+    }
+
+  All functions throw std::runtime_error if the JSON is malformed.
+*/
+class JSONScanner {
+private:
+  // The stream being read, or nullptr if reading from memory
+  std::istream *is;
+
+  // The block of the stream currently being scanned
+  std::vector<char> buffer;
+
+  // The start of the current block, the next character to scan, and the end
+  // of the current block
+  const char *begin;
+  const char *cur;
+  const char *end;
+
+  // The number of bytes scanned before the current block
+  std::size_t consumed;
+
+  bool fill();
+  int peek();
+  char get();
+  void expect(char c);
+  void skipWhitespace();
+  void skipString();
+  void readString(std::string &out);
+  void readLiteral(std::string &out);
+  void skipLiteral();
+  void skipToClose(unsigned int depth);
+
+  [[noreturn]] void error(const std::string &message) const;
+
+public:
+  explicit JSONScanner(std::istream &is, std::size_t blockSize = 65536);
+  JSONScanner(const char *begin, const char *end);
+
+  bool findArray(const std::string &key);
+  bool findString(const std::string &key, std::string &value);
+  bool nextObject();
+  bool nextKey(std::string &key);
+  bool readValue(std::string &out);
+  void skipValue();
+  void skipObject();
+
+  std::size_t offset() const;
+};
+
+#endif // JSONSCAN_H_
@@ -106,13 +106,12 @@ void Measure::setLabel(const std::string &label){
     The value
 */
 double Measure::getValue(int key){
-    // If the size of value is empty or the key does not exist
-    // An exception will be thrown
-    if(values.size() < 1 || this->values.find(key) == this->values.end()){
+    // If the key does not exist, an exception will be thrown
+    double value;
+    if(!this->values.find(key, value)){
         throw std::out_of_range("No value found for year " + std::to_string(key));
-    } else {
-        return this->values[key];
     }
+    return value;
 }
 
 /*
@@ -122,6 +121,17 @@ double Measure::getValue(int key){
         std::map<int, double> All data
  */
 std::map<int, double> Measure::getAllValue() const{
+    return this->values.toMap();
+}
+
+/*
+   This function retrieves all values from this Measure object without
+   copying them, to be iterated in order of year
+
+   @return
+        The values, as pairs of a year and its value
+ */
+const YearValues& Measure::getValues() const{
     return this->values;
 }
 
@@ -140,7 +150,7 @@ std::map<int, double> Measure::getAllValue() const{
     void
 */
 void Measure::setValue(int key, double value){
-    this->values[key] = value;
+    this->values.set(key, value);
 }
 
 
@@ -169,7 +179,7 @@ double Measure::getDifference() const{
     if(this->values.size() < 1){
         return 0;
     } else {
-        return this->values.rbegin()->second - this->values.begin()->second;
+        return this->values.back().second - this->values.front().second;
     }
 }
 
@@ -188,8 +198,8 @@ double Measure::getDifferenceAsPercentage() const{
     if(this->values.size() < 1){
         return 0;
     } else {
-        double firstYearValue = this->values.begin()->second;
-        double finalYearValue = this->values.rbegin()->second;
+        double firstYearValue = this->values.front().second;
+        double finalYearValue = this->values.back().second;
         double result = (finalYearValue - firstYearValue)/firstYearValue * 100;
 
         return result;
@@ -208,8 +218,8 @@ double Measure::getDifferenceAsPercentage() const{
 double Measure::getAverage() const{
     double sum = 0;
     int size = this->values.size();
-    for(auto it = this->values.begin(); it != this->values.end(); it++){
-        sum += it->second;
+    for(auto value : this->values){
+        sum += value.second;
     }
     return sum/size;
 }
@@ -262,9 +272,9 @@ std::ostream& operator<<(std::ostream& os, const Measure& measure){
     os << measure.getLabel() << " (" << measure.getCodename() << ")\n";
     // Check for the largest value in the data
     double largestValue = 0;
-    for(auto it = measure.values.begin(); it != measure.values.end(); it++){
-        if(it->second > largestValue){
-            largestValue = it->second;
+    for(auto value : measure.values){
+        if(value.second > largestValue){
+            largestValue = value.second;
         }
     }
 
@@ -277,9 +287,9 @@ std::ostream& operator<<(std::ostream& os, const Measure& measure){
 
 
     // Printing out all years first
-    for(auto it = measure.values.begin(); it != measure.values.end(); it++){
+    for(auto value : measure.values){
         // Lining up all values to the right hand side
-        os << std::right << std::setw(numberOfDigits) << it->first << " ";
+        os << std::right << std::setw(numberOfDigits) << value.first << " ";
     }
     int numberOfDigitsDifference = 8; // 7 = dot + 6 decimal place
     int largestValueIntDifference = (int) measure.getDifference();
@@ -300,8 +310,8 @@ std::ostream& operator<<(std::ostream& os, const Measure& measure){
     os << "\n";
 
     // Printing all values
-    for(auto it = measure.values.begin(); it != measure.values.end(); it++){
-        os << std::right << std::setprecision(6) << it->second << " ";
+    for(auto value : measure.values){
+        os << std::right << std::setprecision(6) << value.second << " ";
     }
     // Values of final three column
     os << std::right << std::setprecision(6) << measure.getAverage() << " ";
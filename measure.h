@@ -17,6 +17,8 @@
 #include <string>
 #include <map>
 
+#include "yearvalues.h"
+
 /*
   The Measure class contains a measure code, label, and a container for readings
   from across a number of years.
@@ -30,7 +32,7 @@ private:
     std::string codename;
     std::string label;
 
-    std::map<int, double> values;
+    YearValues values;
 
 public:
   Measure();
@@ -44,6 +46,7 @@ public:
   void setValue(int key, double value);
   double getValue(int key);
   std::map<int, double> getAllValue() const;
+  const YearValues& getValues() const;
 
   unsigned int size() const;
   double getDifference() const;
@@ -0,0 +1,358 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the implementation of the functions used to decode the
+  numbers read from the input files. See the header file for how they compare
+  to std::stod and std::stoi.
+
+  Most values in the datasets have few enough significant digits that they
+  can be decoded exactly with a single floating-point multiplication or
+  division (Clinger's fast path). Anything else is handed to std::strtod,
+  which rounds correctly, so the result is always the same as std::stod.
+*/
+
+#include <cerrno>
+#include <cfloat>
+#include <clocale>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "numeric.h"
+
+// The powers of ten that can be represented exactly by a double
+static const double POWERS_OF_TEN[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const int MAX_EXACT_POWER = 22;
+
+// The largest integer below which every integer can be represented exactly
+// by a double
+static const std::uint64_t MAX_EXACT_MANTISSA = std::uint64_t(1) << 53;
+
+// The number of decimal digits that always fit in a std::uint64_t
+static const int MAX_MANTISSA_DIGITS = 19;
+
+// Explicit exponents are clamped to this, which is far beyond the range of
+// a double but cannot overflow an int when the digits are added
+static const int MAX_EXPONENT = 100000;
+
+/*
+  Returns true if c is whitespace, as skipped by std::stod and std::stoi in
+  the "C" locale.
+*/
+static inline bool isSpace(char c){
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+           c == '\r';
+}
+
+/*
+  Returns true if c is a decimal digit.
+*/
+static inline bool isDigit(char c){
+    return c >= '0' && c <= '9';
+}
+
+/*
+  Decode a number that cannot be decoded exactly with the fast path, using
+  std::strtod.
+
+  The number is copied into a buffer on the stack (std::strtod needs a null
+  terminated string), replacing '.' with the decimal point of the current
+  locale, which std::strtod expects.
+
+  @param begin
+    A pointer to the first character of the number, after any whitespace
+
+  @param end
+    A pointer to one past the last character of the number
+
+  @param value
+    Where to store the decoded number
+
+  @return
+    true if the number was decoded, false if it is out of range
+*/
+static bool decodeSlow(const char *begin, const char *end, double &value){
+    char buffer[128];
+    std::string longNumber;
+    std::size_t length = end - begin;
+
+    char *text = buffer;
+    if (length < sizeof(buffer)) {
+        std::memcpy(buffer, begin, length);
+        buffer[length] = '\0';
+    } else {
+        longNumber.assign(begin, end);
+        text = &longNumber[0];
+    }
+
+    const char decimalPoint = *std::localeconv()->decimal_point;
+    if (decimalPoint != '.') {
+        char *point = static_cast<char *>(std::memchr(text, '.', length));
+        if (point != nullptr) {
+            *point = decimalPoint;
+        }
+    }
+
+    char *parsed = nullptr;
+    errno = 0;
+    double result = std::strtod(text, &parsed);
+    if (errno == ERANGE || parsed != text + length) {
+        return false;
+    }
+
+    value = result;
+    return true;
+}
+
+/*
+  Decode a decimal floating-point number at the start of a range of
+  characters, returning exactly the same value as std::stod would.
+
+  @param begin
+    A pointer to the first character
+
+  @param end
+    A pointer to one past the last character
+
+  @param value
+    Where to store the decoded number. Not modified if the number cannot be
+    decoded.
+
+  @return
+    true if a number was decoded, false if the range does not start with a
+    number (after any whitespace) or the number is out of range
+
+  @example
+    double value;
+    if (!BethYw::decodeDouble("7.7399419676118376", value)) {
+      ...
+    }
+*/
+bool BethYw::decodeDouble(const char *begin, const char *end, double &value){
+    const char *p = begin;
+    while (p != end && isSpace(*p)) {
+        p++;
+    }
+
+    const char *start = p;
+    bool negative = false;
+    if (p != end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    // The number is mantissa * 10^exponent. Only the first 19 significant
+    // digits are kept in mantissa, and truncated is set if any of the digits
+    // that did not fit are not zero.
+    std::uint64_t mantissa = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+    bool truncated = false;
+    bool anyDigits = false;
+
+    for (; p != end && isDigit(*p); p++) {
+        anyDigits = true;
+        if (mantissa == 0 && *p == '0') {
+            continue;
+        }
+        if (significantDigits < MAX_MANTISSA_DIGITS) {
+            mantissa = mantissa * 10 + (*p - '0');
+            significantDigits++;
+        } else {
+            truncated = truncated || *p != '0';
+            exponent++;
+        }
+    }
+
+    if (p != end && *p == '.') {
+        p++;
+        for (; p != end && isDigit(*p); p++) {
+            anyDigits = true;
+            if (mantissa == 0 && *p == '0') {
+                exponent--;
+                continue;
+            }
+            if (significantDigits < MAX_MANTISSA_DIGITS) {
+                mantissa = mantissa * 10 + (*p - '0');
+                significantDigits++;
+                exponent--;
+            } else {
+                truncated = truncated || *p != '0';
+            }
+        }
+    }
+
+    if (!anyDigits) {
+        return false;
+    }
+
+    // The exponent is only part of the number if it has at least one digit
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        bool negativeExponent = false;
+        if (q != end && (*q == '+' || *q == '-')) {
+            negativeExponent = *q == '-';
+            q++;
+        }
+
+        if (q != end && isDigit(*q)) {
+            int explicitExponent = 0;
+            for (; q != end && isDigit(*q); q++) {
+                if (explicitExponent < MAX_EXPONENT) {
+                    explicitExponent = explicitExponent * 10 + (*q - '0');
+                }
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            p = q;
+        }
+    }
+
+#if FLT_EVAL_METHOD == 0
+    // Clinger's fast path: when the mantissa and the power of ten are both
+    // exact doubles, a single correctly rounded operation gives the
+    // correctly rounded result
+    if (!truncated) {
+        if (mantissa == 0) {
+            value = negative ? -0.0 : 0.0;
+            return true;
+        }
+
+        if (mantissa <= MAX_EXACT_MANTISSA) {
+            if (exponent >= -MAX_EXACT_POWER && exponent <= MAX_EXACT_POWER) {
+                double result = static_cast<double>(mantissa);
+                if (exponent < 0) {
+                    result /= POWERS_OF_TEN[-exponent];
+                } else {
+                    result *= POWERS_OF_TEN[exponent];
+                }
+                value = negative ? -result : result;
+                return true;
+            }
+
+            // e.g. 12e30 is 12000000e25, where both parts are still exact
+            if (exponent > MAX_EXACT_POWER && exponent <= MAX_EXACT_POWER + 15) {
+                std::uint64_t scaled = mantissa;
+                int extra = exponent - MAX_EXACT_POWER;
+                while (extra > 0 && scaled <= MAX_EXACT_MANTISSA / 10) {
+                    scaled *= 10;
+                    extra--;
+                }
+                if (extra == 0) {
+                    double result = static_cast<double>(scaled) *
+                                    POWERS_OF_TEN[MAX_EXACT_POWER];
+                    value = negative ? -result : result;
+                    return true;
+                }
+            }
+        }
+    }
+#endif
+
+    return decodeSlow(start, p, value);
+}
+
+/*
+  Decode a decimal floating-point number at the start of a string.
+
+  @param str
+    The string to decode
+
+  @param value
+    Where to store the decoded number
+
+  @return
+    true if a number was decoded, false otherwise
+*/
+bool BethYw::decodeDouble(const std::string &str, double &value){
+    return decodeDouble(str.data(), str.data() + str.size(), value);
+}
+
+/*
+  Decode a decimal integer at the start of a range of characters, returning
+  exactly the same value as std::stoi would.
+
+  @param begin
+    A pointer to the first character
+
+  @param end
+    A pointer to one past the last character
+
+  @param value
+    Where to store the decoded number. Not modified if the number cannot be
+    decoded.
+
+  @return
+    true if a number was decoded, false if the range does not start with an
+    integer (after any whitespace) or the integer does not fit in an int
+
+  @example
+    int year;
+    if (!BethYw::decodeInt("2015", year)) {
+      ...
+    }
+*/
+bool BethYw::decodeInt(const char *begin, const char *end, int &value){
+    const char *p = begin;
+    while (p != end && isSpace(*p)) {
+        p++;
+    }
+
+    bool negative = false;
+    if (p != end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    if (p == end || !isDigit(*p)) {
+        return false;
+    }
+
+    // One more than the largest int, which is allowed if negative
+    const std::uint64_t limit =
+        static_cast<std::uint64_t>(std::numeric_limits<int>::max()) + 1;
+
+    std::uint64_t magnitude = 0;
+    for (; p != end && isDigit(*p); p++) {
+        magnitude = magnitude * 10 + (*p - '0');
+        if (magnitude > limit) {
+            return false;
+        }
+    }
+
+    if (negative) {
+        value = static_cast<int>(-static_cast<std::int64_t>(magnitude));
+    } else if (magnitude < limit) {
+        value = static_cast<int>(magnitude);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/*
+  Decode a decimal integer at the start of a string.
+
+  @param str
+    The string to decode
+
+  @param value
+    Where to store the decoded number
+
+  @return
+    true if a number was decoded, false otherwise
+*/
+bool BethYw::decodeInt(const std::string &str, int &value){
+    return decodeInt(str.data(), str.data() + str.size(), value);
+}
@@ -0,0 +1,41 @@
+#ifndef NUMERIC_H_
+#define NUMERIC_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the declarations of the functions used to decode the
+  numbers (years and values) read from the input files.
+
+  Unlike std::stod and std::stoi, these functions read directly from a range
+  of characters, so no temporary std::string is needed, they do not throw
+  exceptions, and they always use '.' as the decimal point whatever the
+  current locale. Otherwise they accept the same text as std::stod and
+  std::stoi, and return bit-identical results:
+
+    - Leading whitespace is skipped
+    - Any characters after the number are ignored (e.g. "2015-16" is 2015)
+    - Numbers that are out of range are rejected
+
+  decodeDouble() only accepts decimal numbers, and not the hexadecimal,
+  infinity and NaN forms also accepted by std::stod (so "0x1A" is decoded as
+  0, and "inf" is rejected).
+ */
+
+#include <string>
+
+namespace BethYw {
+
+bool decodeDouble(const char *begin, const char *end, double &value);
+bool decodeDouble(const std::string &str, double &value);
+
+bool decodeInt(const char *begin, const char *end, int &value);
+bool decodeInt(const std::string &str, int &value);
+
+} // namespace BethYw
+
+#endif // NUMERIC_H_
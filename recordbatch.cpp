@@ -0,0 +1,361 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the implementation of the RecordBatch class. See the
+  header file for what a batch holds, and Areas::ingest() for how it is
+  added to an Areas object.
+*/
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "recordbatch.h"
+
+const std::size_t RecordBatch::DEFAULT_CAPACITY;
+
+/*
+  Construct an empty batch.
+
+  @param capacity
+    The number of values (or areas) the batch holds before it is full
+*/
+RecordBatch::RecordBatch(std::size_t capacity) : limit(capacity){
+    measureColumn.reserve(capacity);
+    yearColumn.reserve(capacity);
+    valueColumn.reserve(capacity);
+}
+
+/*
+  This function finds an area in the batch, adding it if it is not there.
+
+  @param code
+    The local authority code of the area
+
+  @param inserted
+    Set to true if the area was added, false if it was already there
+
+  @return
+    The ID of the area in the batch
+*/
+RecordBatch::ID RecordBatch::insertArea(const std::string &code, bool &inserted){
+    auto it = areaIDs.find(code);
+    inserted = it == areaIDs.end();
+    if(!inserted){
+        return it->second;
+    }
+
+    ID area = static_cast<ID>(areas.size());
+    areaIDs.emplace(code, area);
+    areas.push_back(AreaEntry{code, false, false, {}, {}});
+    return area;
+}
+
+/*
+  This function adds an area to the batch, which is created without a code
+  or names if it does not exist (as by the [] operator of AreasContainer).
+
+  @param code
+    The local authority code of the area
+
+  @return
+    The ID of the area in the batch
+*/
+RecordBatch::ID RecordBatch::addArea(const std::string &code){
+    bool inserted;
+    return insertArea(code, inserted);
+}
+
+/*
+  This function adds an area to the batch, which is created with its code
+  and a name if it does not exist. If the area is already in the batch, the
+  name it was first added with is kept.
+
+  @param code
+    The local authority code of the area
+
+  @param lang
+    A three-letter language code in ISO 639-3 format, e.g. cym or eng
+
+  @param name
+    The name of the area in `lang`
+
+  @return
+    The ID of the area in the batch
+*/
+RecordBatch::ID RecordBatch::addArea(const std::string &code,
+                                     const std::string &lang,
+                                     const std::string &name){
+    bool inserted;
+    ID area = insertArea(code, inserted);
+    if(inserted){
+        areas[area].named = true;
+        areas[area].names.emplace_back(lang, name);
+    }
+    return area;
+}
+
+/*
+  This function adds an area to the batch that replaces any existing area
+  with the same code, with no names or measures until they are added with
+  setName() and addMeasure(). If the area is already in the batch, it is
+  replaced again, losing the names it had.
+
+  @param code
+    The local authority code of the area
+
+  @return
+    The ID of the area in the batch
+
+  @throws
+    std::logic_error if the area already has measures in the batch, since
+    they would be lost
+*/
+RecordBatch::ID RecordBatch::replaceArea(const std::string &code){
+    bool inserted;
+    ID area = insertArea(code, inserted);
+    AreaEntry &entry = areas[area];
+    if(!entry.measures.empty()){
+        throw std::logic_error("RecordBatch::replaceArea: " + code + " already has measures");
+    }
+    entry.replace = true;
+    entry.named = true;
+    entry.names.clear();
+    return area;
+}
+
+/*
+  This function sets a name of an area in the batch, replacing any name it
+  has in the same language.
+
+  @param area
+    The ID of the area in the batch
+
+  @param lang
+    A three-letter language code in ISO 639-3 format, e.g. cym or eng
+
+  @param name
+    The name of the area in `lang`
+*/
+void RecordBatch::setName(ID area, const std::string &lang, const std::string &name){
+    areas.at(area).named = true;
+    areas.at(area).names.emplace_back(lang, name);
+}
+
+/*
+  This function finds an area in the batch.
+
+  @param code
+    The local authority code of the area
+
+  @param area
+    Set to the ID of the area in the batch, if it is there
+
+  @return
+    true if the area is in the batch, false otherwise
+*/
+bool RecordBatch::findArea(const std::string &code, ID &area) const{
+    auto it = areaIDs.find(code);
+    if(it == areaIDs.end()){
+        return false;
+    }
+    area = it->second;
+    return true;
+}
+
+/*
+  This function adds a measure of an area to the batch, which is created
+  with a label if the area does not have it. If the measure is already in
+  the batch, the label it was first added with is kept.
+
+  @param area
+    The ID of the area in the batch
+
+  @param codename
+    The (lowercase) codename of the measure
+
+  @param label
+    The label of the measure
+
+  @return
+    The ID of the measure in the batch
+*/
+RecordBatch::ID RecordBatch::addMeasure(ID area, const std::string &codename, const std::string &label){
+    ID measure;
+    if(findMeasure(area, codename, measure)){
+        return measure;
+    }
+
+    measure = static_cast<ID>(measures.size());
+    measures.push_back(MeasureEntry{area, codename, label});
+    areas[area].measures.emplace_back(codename, measure);
+    return measure;
+}
+
+/*
+  This function finds a measure of an area in the batch. An area only has a
+  few measures, so they are searched in turn.
+
+  @param area
+    The ID of the area in the batch
+
+  @param codename
+    The (lowercase) codename of the measure
+
+  @param measure
+    Set to the ID of the measure in the batch, if it is there
+
+  @return
+    true if the measure is in the batch, false otherwise
+*/
+bool RecordBatch::findMeasure(ID area, const std::string &codename, ID &measure) const{
+    for(const auto &entry : areas.at(area).measures){
+        if(entry.first == codename){
+            measure = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+  This function adds a value of a measure to the batch.
+
+  @param measure
+    The ID of the measure in the batch
+
+  @param year
+    The year of the value
+
+  @param value
+    The value
+*/
+void RecordBatch::addValue(ID measure, int year, double value){
+    measureColumn.push_back(measure);
+    yearColumn.push_back(year);
+    valueColumn.push_back(value);
+}
+
+/*
+  These functions get the areas, measures and values in the batch, in the
+  order they were added. The ID of an area or measure is its position, and
+  the columns of the values are all the same length.
+*/
+const std::vector<RecordBatch::AreaEntry> &RecordBatch::getAreas() const{
+    return areas;
+}
+
+const std::vector<RecordBatch::MeasureEntry> &RecordBatch::getMeasures() const{
+    return measures;
+}
+
+const std::vector<RecordBatch::ID> &RecordBatch::getMeasureColumn() const{
+    return measureColumn;
+}
+
+const std::vector<int> &RecordBatch::getYearColumn() const{
+    return yearColumn;
+}
+
+const std::vector<double> &RecordBatch::getValueColumn() const{
+    return valueColumn;
+}
+
+/*
+  This function gets the number of values in the batch.
+
+  @return
+    The number of values
+*/
+std::size_t RecordBatch::size() const{
+    return valueColumn.size();
+}
+
+/*
+  This function gets the number of values (or areas) the batch holds before
+  it is full.
+
+  @return
+    The capacity of the batch
+*/
+std::size_t RecordBatch::capacity() const{
+    return limit;
+}
+
+/*
+  This function tests whether the batch is empty, i.e. has no areas (and so
+  no measures or values either).
+
+  @return
+    true if the batch is empty, false otherwise
+*/
+bool RecordBatch::empty() const{
+    return areas.empty();
+}
+
+/*
+  This function tests whether the batch is full, i.e. has as many values or
+  areas as its capacity, and so should be passed to a RecordSink and cleared
+  before any more are added.
+
+  @return
+    true if the batch is full, false otherwise
+*/
+bool RecordBatch::full() const{
+    return valueColumn.size() >= limit || areas.size() >= limit;
+}
+
+/*
+  This function removes everything from the batch, keeping the memory it
+  used for the next batch.
+*/
+void RecordBatch::clear(){
+    areaIDs.clear();
+    areas.clear();
+    measures.clear();
+    measureColumn.clear();
+    yearColumn.clear();
+    valueColumn.clear();
+}
+
+RecordSink::~RecordSink() {}
+
+/*
+  This function tests whether the sink already has an area, in which case
+  its names do not need to be added to a batch. By default, it does not.
+
+  @param code
+    The local authority code of the area
+
+  @return
+    true if the sink has the area, false otherwise
+*/
+bool RecordSink::contains(const std::string &) const{
+    return false;
+}
+
+/*
+  This function tests whether the sink already has a measure of an area, in
+  which case its label does not need to be added to a batch. By default, it
+  does not.
+
+  @param code
+    The local authority code of the area
+
+  @param codename
+    The (lowercase) codename of the measure
+
+  @return
+    true if the sink has the measure, false otherwise
+*/
+bool RecordSink::contains(const std::string &, const std::string &) const{
+    return false;
+}
@@ -0,0 +1,147 @@
+#ifndef RECORDBATCH_H_
+#define RECORDBATCH_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the declaration of the RecordBatch class, which holds
+  the areas, measures and values decoded from a number of records of a
+  dataset, so that they can be added to an Areas object all at once (see
+  Areas::ingest()).
+
+  Each distinct area and measure (of an area) is only held once in a batch,
+  and each value refers to its measure by its position in the batch, so
+  adding a batch to an Areas object only looks up each area and measure in
+  it once, however many values they have. Only these IDs are interned: the
+  codes and names of areas, and the codenames and labels of measures, are
+  still strings in each AreaEntry and MeasureEntry, once per batch, as they
+  are needed to find or create the Area and Measure they are added to.
+
+  The values are held in columns (the measure, year and value of each), with
+  room reserved for the capacity of the batch (see full()), so the same
+  batch can be filled, passed to a RecordSink and cleared again for the
+  whole of a file without allocating any more memory for them.
+
+  Adding a batch has the same result as adding everything in it one after
+  the other, in the order it was added to the batch:
+
+    - An area or measure is only created if it does not already exist, and
+      then with the name or label it was first given
+    - A value replaces any earlier value for the same year
+    - A replaced area (see replaceArea()) replaces any existing area with
+      the same code, including its measures, as areas.csv does
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class RecordBatch {
+public:
+  using ID = std::uint32_t;
+
+  struct AreaEntry {
+    std::string code;
+
+    // Whether the area replaces any existing area with the same code
+    bool replace;
+
+    // Whether the area is created with its code (and names), rather than as
+    // an empty Area
+    bool named;
+
+    // The names of the area, as pairs of a language and a name
+    std::vector<std::pair<std::string, std::string>> names;
+
+    // The measures of the area, as pairs of a codename and an ID
+    std::vector<std::pair<std::string, ID>> measures;
+  };
+
+  struct MeasureEntry {
+    ID area;
+    std::string codename;
+    std::string label;
+  };
+
+  // The number of values (or areas) a batch holds before it is full
+  static const std::size_t DEFAULT_CAPACITY = 4096;
+
+private:
+  std::size_t limit;
+  std::unordered_map<std::string, ID> areaIDs;
+  std::vector<AreaEntry> areas;
+  std::vector<MeasureEntry> measures;
+
+  // The values, by column
+  std::vector<ID> measureColumn;
+  std::vector<int> yearColumn;
+  std::vector<double> valueColumn;
+
+  ID insertArea(const std::string &code, bool &inserted);
+
+public:
+  explicit RecordBatch(std::size_t capacity = DEFAULT_CAPACITY);
+
+  ID addArea(const std::string &code);
+  ID addArea(const std::string &code, const std::string &lang, const std::string &name);
+  ID replaceArea(const std::string &code);
+  void setName(ID area, const std::string &lang, const std::string &name);
+  bool findArea(const std::string &code, ID &area) const;
+
+  ID addMeasure(ID area, const std::string &codename, const std::string &label);
+  bool findMeasure(ID area, const std::string &codename, ID &measure) const;
+
+  void addValue(ID measure, int year, double value);
+
+  const std::vector<AreaEntry> &getAreas() const;
+  const std::vector<MeasureEntry> &getMeasures() const;
+  const std::vector<ID> &getMeasureColumn() const;
+  const std::vector<int> &getYearColumn() const;
+  const std::vector<double> &getValueColumn() const;
+
+  std::size_t size() const;
+  std::size_t capacity() const;
+  bool empty() const;
+  bool full() const;
+  void clear();
+};
+
+/*
+  A RecordSink is given the batches of records decoded from a file by the
+  parsers of Areas, in the order they were read, e.g. to add them to an
+  AreasContainer (see AreasSink in areas.h). A batch is only valid until
+  consume() returns, since the parser then clears it to read the next one.
+
+  A parser only adds the name of an area (or the label of a measure) to a
+  batch if the sink does not already have it, which it finds with
+  contains(). By default, a sink has nothing, so every name and label is
+  added the first time the area or measure is.
+
+  consume() is called on the parser's thread, so a batch is added to the
+  sink before the next one is read, rather than while it is. Each dataset
+  file (or page of one) decodes to a single batch, as StatsWales returns at
+  most 1,000 records at a time and a batch holds 4,096 values, and adding
+  it takes a few percent of the time taken to import it, about as long as
+  handing it to another thread would take. contains() would also then read the container that the other
+  thread is adding to. Threads are put to better use where more than one is
+  wanted (see Areas::setThreads()): the datasets are then imported at the
+  same time, and a large StatsWales JSON file in chunks.
+*/
+class RecordSink {
+public:
+  virtual ~RecordSink();
+
+  virtual void consume(const RecordBatch &batch) = 0;
+
+  virtual bool contains(const std::string &code) const;
+  virtual bool contains(const std::string &code, const std::string &codename) const;
+};
+
+#endif // RECORDBATCH_H_
@@ -0,0 +1,522 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the implementation of the RecordIndex class. See the
+  header file for the layout of an index's sidecar file.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "input.h"
+#include "jsonscan.h"
+#include "recordindex.h"
+
+// The first bytes of a sidecar file (ending in the version of its format, which
+// is increased whenever its header changes, so that old sidecars are built
+// again), followed by a number that is read back differently on a machine with
+// a different byte order
+static const char INDEX_MAGIC[8] = {'B', 'Y', 'W', 'I', 'D', 'X', '0', '2'};
+static const std::uint32_t INDEX_BYTE_ORDER = 0x01020304;
+
+// How much of the start and of the end of a file is hashed
+static const std::size_t HASHED_SIZE = 64 * 1024;
+
+/*
+  These functions write a number or a string to a sidecar file.
+*/
+template <typename T>
+static void write(std::ostream &os, T value){
+    os.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+static void write(std::ostream &os, const std::string &value){
+    write<std::uint32_t>(os, static_cast<std::uint32_t>(value.size()));
+    os.write(value.data(), value.size());
+}
+
+/*
+  These functions read a number or a string from a sidecar file.
+
+  @throws
+    std::runtime_error if the file ends first
+*/
+template <typename T>
+static T read(std::istream &is){
+    T value;
+    if (!is.read(reinterpret_cast<char *>(&value), sizeof(value))) {
+        throw std::runtime_error("RecordIndex: Unexpected end of index");
+    }
+    return value;
+}
+
+static std::string read(std::istream &is){
+    std::uint32_t size = read<std::uint32_t>(is);
+    std::string value(size, '\0');
+    if (size > 0 && !is.read(&value[0], size)) {
+        throw std::runtime_error("RecordIndex: Unexpected end of index");
+    }
+    return value;
+}
+
+/*
+  This function finds the names of the columns the index is built from, so
+  that an index is built again if they change.
+
+  @param cols
+    The column mapping of the dataset
+
+  @param authKey
+    Set to the key of the authority code
+
+  @param measureKey
+    Set to the key of the measure code, or for a file with a single measure,
+    to '=' followed by its code
+
+  @return
+    false if cols does not name the columns, so the file cannot be indexed
+*/
+static bool indexKeys(const BethYw::SourceColumnMapping &cols, std::string &authKey, std::string &measureKey){
+    auto authCode = cols.find(BethYw::SourceColumn::AUTH_CODE);
+    auto measureCode = cols.find(BethYw::SourceColumn::MEASURE_CODE);
+    auto singleMeasureCode = cols.find(BethYw::SourceColumn::SINGLE_MEASURE_CODE);
+    if (authCode == cols.end() || (measureCode == cols.end() && singleMeasureCode == cols.end())) {
+        return false;
+    }
+
+    authKey = authCode->second;
+    if (measureCode != cols.end()) {
+        measureKey = measureCode->second;
+    } else {
+        measureKey = "=" + singleMeasureCode->second;
+    }
+    return true;
+}
+
+/*
+  Constructor for a RecordIndex.
+
+  @param path
+    The path of the index's sidecar file
+
+  @example
+    RecordIndex index("datasets/popu1009.json" + BethYw::INDEX_SUFFIX);
+    if (index.open("datasets/popu1009.json", data, size, cols)) {
+      for (auto range : index.select(&areasFilter, &measuresFilter)) {
+        ...
+      }
+    }
+*/
+RecordIndex::RecordIndex(const std::string &path) : path(path), size(0), built(false) {}
+
+/*
+  This function opens the index of a StatsWales JSON file, reading it from
+  its sidecar file if that is up to date, or else building it and writing the
+  sidecar file.
+
+  @param filePath
+    The path of the file
+
+  @param data
+    The contents of the file, e.g. from InputMappedFile::data()
+
+  @param size
+    The size of the file
+
+  @param cols
+    The column mapping of the dataset
+
+  @return
+    true if the index can be used, false if the file could not be indexed
+    (e.g. it is malformed, or a record has no authority code), in which case
+    the file should be read in full
+*/
+bool RecordIndex::open(const std::string &filePath,
+                       const char *data,
+                       std::size_t size,
+                       const BethYw::SourceColumnMapping &cols){
+    std::string authKey;
+    std::string measureKey;
+    if (!indexKeys(cols, authKey, measureKey)) {
+        return false;
+    }
+
+    long long fileSize = 0;
+    long long modified = 0;
+    unsigned long long inode = 0;
+    if (!fileStatus(filePath, fileSize, modified, inode) || static_cast<std::size_t>(fileSize) != size) {
+        return false;
+    }
+    std::uint64_t fileHash = hash(data, size);
+
+    this->size = size;
+    if (load(modified, inode, fileHash, authKey, measureKey)) {
+        return true;
+    }
+    if (!build(data, size, cols)) {
+        return false;
+    }
+    save(modified, inode, fileHash, authKey, measureKey);
+    return true;
+}
+
+/*
+  This function gets the size of the file the index is of.
+
+  @return
+    The size of the file, in bytes
+*/
+std::uint64_t RecordIndex::getSize() const{
+    return size;
+}
+
+/*
+  This function hashes the start and end of a file (with 64-bit FNV-1a), so
+  that checking an index is up to date does not read all of a large file.
+
+  @param data
+    The contents of the file
+
+  @param size
+    The size of the file
+
+  @return
+    The hash
+*/
+std::uint64_t RecordIndex::hash(const char *data, std::size_t size){
+    std::uint64_t value = 14695981039346656037ULL;
+    auto add = [&value](const char *begin, const char *end) {
+        for (const char *c = begin; c < end; c++) {
+            value ^= static_cast<unsigned char>(*c);
+            value *= 1099511628211ULL;
+        }
+    };
+
+    std::size_t head = std::min(size, HASHED_SIZE);
+    add(data, data + head);
+    add(data + std::max(head, size - std::min(size, HASHED_SIZE)), data + size);
+    return value;
+}
+
+/*
+  This function builds the index by scanning the file.
+
+  @param data
+    The contents of the file
+
+  @param size
+    The size of the file
+
+  @param cols
+    The column mapping of the dataset
+
+  @return
+    false if the file could not be indexed
+*/
+bool RecordIndex::build(const char *data, std::size_t size, const BethYw::SourceColumnMapping &cols){
+    std::string authKey;
+    std::string measureKey;
+    if (!indexKeys(cols, authKey, measureKey)) {
+        return false;
+    }
+    bool singleMeasure = measureKey[0] == '=';
+
+    std::string singleMeasureCode;
+    if (singleMeasure) {
+        singleMeasureCode = measureKey.substr(1);
+        std::transform(singleMeasureCode.begin(), singleMeasureCode.end(),
+                       singleMeasureCode.begin(), ::tolower);
+    }
+
+    try {
+        JSONScanner scanner(data, data + size);
+        if (!scanner.findArray("value")) {
+            return false;
+        }
+
+        std::string key;
+        std::string value;
+        while (scanner.nextObject()) {
+            std::uint64_t start = scanner.offset() - 1;
+            std::string areaCode;
+            std::string measureCode = singleMeasureCode;
+            bool hasArea = false;
+            bool hasMeasure = singleMeasure;
+
+            while (scanner.nextKey(key)) {
+                bool isArea = key == authKey;
+                bool isMeasure = !singleMeasure && key == measureKey;
+                if (!isArea && !isMeasure) {
+                    scanner.skipValue();
+                    continue;
+                }
+
+                // A record with the same key twice, or without a code, is
+                // left for the importer to deal with as it sees fit
+                bool isString = scanner.readValue(value);
+                if ((isArea && hasArea) || (isMeasure && hasMeasure) || (!isString && value == "null")) {
+                    return false;
+                }
+                if (isArea) {
+                    areaCode = value;
+                    hasArea = true;
+                }
+                if (isMeasure) {
+                    measureCode = value;
+                    std::transform(measureCode.begin(), measureCode.end(), measureCode.begin(), ::tolower);
+                    hasMeasure = true;
+                }
+            }
+            if (!hasArea || !hasMeasure) {
+                return false;
+            }
+
+            areaRanges[areaCode].push_back(Range(start, scanner.offset()));
+            measureStarts[measureCode].push_back(start);
+        }
+    } catch (const std::exception &e) {
+        areaRanges.clear();
+        measureStarts.clear();
+        return false;
+    }
+    built = true;
+    return true;
+}
+
+/*
+  This function reads the header and directory of the sidecar file, if it
+  is of the same file and columns.
+
+  @param modified, inode, hash, authKey, measureKey
+    The modification time (in nanoseconds), inode and hash of the file, and
+    the columns it is indexed by
+
+  @return
+    true if the sidecar file is up to date
+*/
+bool RecordIndex::load(std::int64_t modified, std::uint64_t inode, std::uint64_t hash,
+                       const std::string &authKey, const std::string &measureKey){
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) {
+        return false;
+    }
+
+    try {
+        char magic[sizeof(INDEX_MAGIC)];
+        if (!ifs.read(magic, sizeof(magic)) || std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0 ||
+            read<std::uint32_t>(ifs) != INDEX_BYTE_ORDER || read<std::uint64_t>(ifs) != size ||
+            read<std::int64_t>(ifs) != modified || read<std::uint64_t>(ifs) != inode ||
+            read<std::uint64_t>(ifs) != hash ||
+            read(ifs) != authKey || read(ifs) != measureKey) {
+            return false;
+        }
+
+        // Every list must be within the sidecar file, so that select() can
+        // read them without checking
+        std::uint64_t end = 0;
+        std::map<std::string, List> *directories[] = {&areas, &measures};
+        std::uint64_t entrySizes[] = {2 * sizeof(std::uint64_t), sizeof(std::uint64_t)};
+        for (int d = 0; d < 2; d++) {
+            std::uint32_t entries = read<std::uint32_t>(ifs);
+            for (std::uint32_t i = 0; i < entries; i++) {
+                std::string code = read(ifs);
+                List list;
+                list.position = read<std::uint64_t>(ifs);
+                list.count = read<std::uint64_t>(ifs);
+                (*directories[d])[code] = list;
+                end = std::max(end, list.position + list.count * entrySizes[d]);
+            }
+        }
+
+        ifs.seekg(0, std::ios::end);
+        if (!ifs || static_cast<std::uint64_t>(ifs.tellg()) < end) {
+            throw std::runtime_error("RecordIndex: Unexpected end of index");
+        }
+    } catch (const std::runtime_error &e) {
+        areas.clear();
+        measures.clear();
+        return false;
+    }
+    return true;
+}
+
+/*
+  This function writes the index just built to the sidecar file. It is
+  written to a temporary file of its own first (see temporaryFilePath()), so
+  that another run of the program never reads half an index, even if it is
+  writing the same index at the same time. If it cannot be written, the index just built is used
+  anyway, and built again next time.
+
+  @param modified, inode, hash, authKey, measureKey
+    The modification time (in nanoseconds), inode and hash of the file, and
+    the columns it is indexed by
+*/
+void RecordIndex::save(std::int64_t modified, std::uint64_t inode, std::uint64_t hash,
+                       const std::string &authKey, const std::string &measureKey){
+    // The lists follow the directory, so the size of the directory is needed
+    // to know where they will be
+    std::uint64_t position = sizeof(INDEX_MAGIC) + sizeof(std::uint32_t) + 4 * sizeof(std::uint64_t) +
+                             sizeof(std::uint32_t) + authKey.size() +
+                             sizeof(std::uint32_t) + measureKey.size() + 2 * sizeof(std::uint32_t);
+    for (const auto &area : areaRanges) {
+        position += sizeof(std::uint32_t) + area.first.size() + 2 * sizeof(std::uint64_t);
+    }
+    for (const auto &measure : measureStarts) {
+        position += sizeof(std::uint32_t) + measure.first.size() + 2 * sizeof(std::uint64_t);
+    }
+
+    const std::string temporary = temporaryFilePath(path);
+    {
+        std::ofstream ofs(temporary, std::ios::binary);
+        if (!ofs.is_open()) {
+            return;
+        }
+
+        ofs.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        write<std::uint32_t>(ofs, INDEX_BYTE_ORDER);
+        write<std::uint64_t>(ofs, size);
+        write<std::int64_t>(ofs, modified);
+        write<std::uint64_t>(ofs, inode);
+        write<std::uint64_t>(ofs, hash);
+        write(ofs, authKey);
+        write(ofs, measureKey);
+
+        write<std::uint32_t>(ofs, static_cast<std::uint32_t>(areaRanges.size()));
+        for (const auto &area : areaRanges) {
+            write(ofs, area.first);
+            write<std::uint64_t>(ofs, position);
+            write<std::uint64_t>(ofs, area.second.size());
+            position += area.second.size() * 2 * sizeof(std::uint64_t);
+        }
+        write<std::uint32_t>(ofs, static_cast<std::uint32_t>(measureStarts.size()));
+        for (const auto &measure : measureStarts) {
+            write(ofs, measure.first);
+            write<std::uint64_t>(ofs, position);
+            write<std::uint64_t>(ofs, measure.second.size());
+            position += measure.second.size() * sizeof(std::uint64_t);
+        }
+
+        for (const auto &area : areaRanges) {
+            for (const Range &range : area.second) {
+                write<std::uint64_t>(ofs, range.first);
+                write<std::uint64_t>(ofs, range.second);
+            }
+        }
+        for (const auto &measure : measureStarts) {
+            for (std::uint64_t start : measure.second) {
+                write<std::uint64_t>(ofs, start);
+            }
+        }
+
+        if (!ofs) {
+            ofs.close();
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+    }
+}
+
+/*
+  This function finds the records that importing the file with a set of
+  filters needs to read, which are those of the accepted areas with an
+  accepted measure, and the first record of each accepted area (which
+  creates the Area, whether or not its measure is accepted). Reading these
+  records in order has the same result as reading the whole file.
+
+  @param areasFilter, measuresFilter
+    See Areas::populateFromWelshStatsJSON()
+
+  @return
+    The byte ranges of the records, in the order they are in the file
+
+  @throws
+    std::runtime_error if the sidecar file cannot be read
+*/
+std::vector<RecordIndex::Range> RecordIndex::select(const StringFilterSet * const areasFilter,
+                                                    const StringFilterSet * const measuresFilter) const{
+    bool allAreas = areasFilter == nullptr || areasFilter->empty();
+    bool allMeasures = measuresFilter == nullptr || measuresFilter->empty();
+
+    std::ifstream ifs;
+    if (!built) {
+        ifs.open(path, std::ios::binary);
+        if (!ifs.is_open()) {
+            throw std::runtime_error("RecordIndex: Failed to open index " + path);
+        }
+    }
+
+    // The starts of the records with an accepted measure
+    std::unordered_set<std::uint64_t> measureAccepted;
+    if (!allMeasures) {
+        for (const std::string &code : *measuresFilter) {
+            if (built) {
+                auto it = measureStarts.find(code);
+                if (it != measureStarts.end()) {
+                    measureAccepted.insert(it->second.begin(), it->second.end());
+                }
+            } else {
+                auto it = measures.find(code);
+                if (it != measures.end()) {
+                    ifs.seekg(it->second.position);
+                    for (std::uint64_t i = 0; i < it->second.count; i++) {
+                        measureAccepted.insert(read<std::uint64_t>(ifs));
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<Range> selected;
+    auto addArea = [&](const std::vector<Range> &ranges) {
+        for (std::size_t i = 0; i < ranges.size(); i++) {
+            if (i == 0 || allMeasures || measureAccepted.count(ranges[i].first) > 0) {
+                selected.push_back(ranges[i]);
+            }
+        }
+    };
+    auto addList = [&](const List &list) {
+        std::vector<Range> ranges(list.count);
+        ifs.seekg(list.position);
+        for (Range &range : ranges) {
+            range.first = read<std::uint64_t>(ifs);
+            range.second = read<std::uint64_t>(ifs);
+        }
+        addArea(ranges);
+    };
+
+    if (built) {
+        for (const auto &area : areaRanges) {
+            if (allAreas || areasFilter->find(area.first) != areasFilter->end()) {
+                addArea(area.second);
+            }
+        }
+    } else if (allAreas) {
+        for (const auto &area : areas) {
+            addList(area.second);
+        }
+    } else {
+        for (const std::string &code : *areasFilter) {
+            auto it = areas.find(code);
+            if (it != areas.end()) {
+                addList(it->second);
+            }
+        }
+    }
+
+    std::sort(selected.begin(), selected.end());
+    return selected;
+}
@@ -0,0 +1,88 @@
+#ifndef RECORDINDEX_H_
+#define RECORDINDEX_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the declaration of the RecordIndex class, which indexes
+  where the records (i.e. the elements of the "value" array) of a StatsWales
+  JSON file are, by their authority code and measure code. With an index, a
+  query for a few areas only reads the records of those areas, rather than
+  scanning the whole file.
+
+  An index is built the first time a file is imported with an area or
+  measure filter, and kept in a sidecar file next to it (the file's path
+  followed by BethYw::INDEX_SUFFIX). The sidecar records the size,
+  modification time (in nanoseconds), inode and a hash of the start and end
+  of the file it indexes (see fileStatus()), and is built again if any of
+  these change. It is laid out so that only the lists of records for the
+  requested areas and measures are read from it:
+
+    header       magic, file size, modification time, inode, hash, column
+                 names
+    directory    for each area, and then each measure: its code, and the
+                 position and length of its list of records
+    lists        for an area, the byte range of each of its records; for a
+                 measure, the start of each of its records
+
+  with every list in the order of the records in the file.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "areas.h"
+#include "datasets.h"
+
+class RecordIndex {
+public:
+  // The byte range of a record, from its '{' to just after its '}'
+  using Range = std::pair<std::uint64_t, std::uint64_t>;
+
+private:
+  // Where a list of records is in the sidecar, and how many records it has
+  struct List {
+    std::uint64_t position;
+    std::uint64_t count;
+  };
+
+  std::string path;
+  std::uint64_t size;
+  bool built;
+  std::map<std::string, List> areas;
+  std::map<std::string, List> measures;
+
+  // The ranges of the records, if the index was built rather than read
+  std::map<std::string, std::vector<Range>> areaRanges;
+  std::map<std::string, std::vector<std::uint64_t>> measureStarts;
+
+  bool build(const char *data, std::size_t size, const BethYw::SourceColumnMapping &cols);
+  bool load(std::int64_t modified, std::uint64_t inode, std::uint64_t hash,
+            const std::string &authKey, const std::string &measureKey);
+  void save(std::int64_t modified, std::uint64_t inode, std::uint64_t hash,
+            const std::string &authKey, const std::string &measureKey);
+
+public:
+  RecordIndex(const std::string &path);
+
+  bool open(const std::string &filePath,
+            const char *data,
+            std::size_t size,
+            const BethYw::SourceColumnMapping &cols);
+
+  std::uint64_t getSize() const;
+  std::vector<Range> select(const StringFilterSet * const areasFilter,
+                            const StringFilterSet * const measuresFilter) const;
+
+  static std::uint64_t hash(const char *data, std::size_t size);
+};
+
+#endif // RECORDINDEX_H_
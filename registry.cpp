@@ -0,0 +1,231 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the implementation of the DatasetRegistry class. See the
+  header file for the format of a manifest.
+ */
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "lib_json.hpp"
+
+#include "registry.h"
+
+using json = nlohmann::json;
+
+/*
+  Constructor for a DatasetRegistry, which registers the datasets built into
+  the program straight away, but does not read the manifest until it is
+  needed.
+
+  @param manifestPath
+    The path of the manifest, or an empty string for no manifest
+
+  @param manifestRequired
+    Whether it is an error for the manifest not to exist (if not, a missing
+    manifest registers no datasets)
+
+  @example
+    DatasetRegistry registry("datasets/manifest.json");
+    const BethYw::InputFileSource *source = registry.find("trains");
+*/
+DatasetRegistry::DatasetRegistry(const std::string &manifestPath, bool manifestRequired)
+    : manifestPath(manifestPath), manifestRequired(manifestRequired),
+      manifestLoaded(manifestPath.empty()){
+    for (const auto &source : BethYw::InputFiles::DATASETS) {
+        if (sources.emplace(source.CODE, &source).second) {
+            codes.push_back(source.CODE);
+        }
+    }
+}
+
+/*
+  This function reads the manifest, and indexes its entries by their code.
+  The entries are not turned into InputFileSources until they are looked up.
+
+  @throws
+    std::runtime_error if the manifest is required but cannot be opened, or
+    is malformed
+*/
+void DatasetRegistry::loadManifest(){
+    if (manifestLoaded) {
+        return;
+    }
+    manifestLoaded = true;
+
+    std::ifstream ifs(manifestPath);
+    if (!ifs.is_open()) {
+        if (manifestRequired) {
+            throw std::runtime_error("DatasetRegistry: Failed to open manifest " + manifestPath);
+        }
+        return;
+    }
+
+    json manifest;
+    try {
+        ifs >> manifest;
+    } catch (const json::exception &e) {
+        throw std::runtime_error("DatasetRegistry: Malformed manifest " + manifestPath + ": " + e.what());
+    }
+
+    auto datasets = manifest.find("datasets");
+    if (!manifest.is_object() || datasets == manifest.end() || !datasets->is_array()) {
+        throw std::runtime_error("DatasetRegistry: Malformed manifest " + manifestPath +
+                                 ": there is no \"datasets\" array");
+    }
+
+    for (const auto &entry : *datasets) {
+        auto code = entry.find("code");
+        if (!entry.is_object() || code == entry.end() || !code->is_string()) {
+            throw std::runtime_error("DatasetRegistry: Malformed manifest " + manifestPath +
+                                     ": a dataset has no code");
+        }
+
+        const std::string &key = code->get_ref<const std::string &>();
+        if (sources.find(key) == sources.end() && entries.find(key) == entries.end()) {
+            entries.emplace(key, entry.dump());
+            codes.push_back(key);
+        }
+    }
+}
+
+/*
+  This function creates the InputFileSource for an entry of the manifest.
+
+  @param entry
+    The entry, as JSON
+
+  @return
+    The InputFileSource
+
+  @throws
+    std::runtime_error if the entry is malformed
+*/
+std::unique_ptr<BethYw::InputFileSource> DatasetRegistry::parseEntry(const std::string &entry){
+    static const std::unordered_map<std::string, BethYw::SourceDataType> PARSERS = {
+        {"AuthorityCodeCSV", BethYw::AuthorityCodeCSV},
+        {"WelshStatsJSON", BethYw::WelshStatsJSON},
+        {"AuthorityByYearCSV", BethYw::AuthorityByYearCSV}
+    };
+    static const std::unordered_map<std::string, BethYw::SourceColumn> COLUMNS = {
+        {"AUTH_CODE", BethYw::AUTH_CODE},
+        {"AUTH_NAME_ENG", BethYw::AUTH_NAME_ENG},
+        {"AUTH_NAME_CYM", BethYw::AUTH_NAME_CYM},
+        {"MEASURE_CODE", BethYw::MEASURE_CODE},
+        {"MEASURE_NAME", BethYw::MEASURE_NAME},
+        {"SINGLE_MEASURE_CODE", BethYw::SINGLE_MEASURE_CODE},
+        {"SINGLE_MEASURE_NAME", BethYw::SINGLE_MEASURE_NAME},
+        {"YEAR", BethYw::YEAR},
+        {"VALUE", BethYw::VALUE}
+    };
+
+    json j = json::parse(entry);
+    std::string code = j["code"].get<std::string>();
+
+    try {
+        std::string file = j.at("file").get<std::string>();
+        std::string name = j.value("name", code);
+
+        auto parser = PARSERS.find(j.at("parser").get<std::string>());
+        if (parser == PARSERS.end()) {
+            throw std::runtime_error("unknown parser " + j.at("parser").get<std::string>());
+        }
+
+        BethYw::SourceColumnMapping cols;
+        for (const auto &column : j.at("cols").items()) {
+            auto key = COLUMNS.find(column.key());
+            if (key == COLUMNS.end()) {
+                throw std::runtime_error("unknown column " + column.key());
+            }
+            cols.emplace(key->second, column.value().get<std::string>());
+        }
+
+        return std::unique_ptr<BethYw::InputFileSource>(
+            new BethYw::InputFileSource{code, name, file, parser->second, cols});
+    } catch (const json::exception &e) {
+        throw std::runtime_error("DatasetRegistry: Malformed dataset " + code + ": " + e.what());
+    } catch (const std::runtime_error &e) {
+        throw std::runtime_error("DatasetRegistry: Malformed dataset " + code + ": " + e.what());
+    }
+}
+
+/*
+  This function finds the dataset with a code, reading the manifest if it is
+  not built in.
+
+  @param code
+    The code of the dataset, as used in the program arguments
+
+  @return
+    A pointer to the InputFileSource of the dataset, which is valid for the
+    lifetime of the registry, or nullptr if no dataset has the code
+
+  @throws
+    std::runtime_error if the manifest (or the dataset's entry) is malformed
+*/
+const BethYw::InputFileSource *DatasetRegistry::find(const std::string &code){
+    auto it = sources.find(code);
+    if (it != sources.end()) {
+        return it->second;
+    }
+
+    loadManifest();
+    auto entry = entries.find(code);
+    if (entry == entries.end()) {
+        return nullptr;
+    }
+
+    created.push_back(parseEntry(entry->second));
+    const BethYw::InputFileSource *source = created.back().get();
+    sources.emplace(code, source);
+    entries.erase(entry);
+    return source;
+}
+
+/*
+  This function finds the dataset with a code, reading the manifest if it is
+  not built in.
+
+  @param code
+    The code of the dataset, as used in the program arguments
+
+  @return
+    The InputFileSource of the dataset, which is valid for the lifetime of
+    the registry
+
+  @throws
+    std::out_of_range if no dataset has the code
+    std::runtime_error if the manifest (or the dataset's entry) is malformed
+*/
+const BethYw::InputFileSource &DatasetRegistry::at(const std::string &code){
+    const BethYw::InputFileSource *source = find(code);
+    if (source == nullptr) {
+        throw std::out_of_range("No dataset matches key: " + code);
+    }
+    return *source;
+}
+
+/*
+  This function gets the codes of every dataset, reading the manifest.
+
+  @return
+    The codes, with the built-in datasets first and then those in the
+    manifest, in order
+
+  @throws
+    std::runtime_error if the manifest is malformed
+*/
+const std::vector<std::string> &DatasetRegistry::getCodes(){
+    loadManifest();
+    return codes;
+}
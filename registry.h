@@ -0,0 +1,80 @@
+#ifndef REGISTRY_H_
+#define REGISTRY_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the declaration of the DatasetRegistry class, which
+  finds the InputFileSource for a dataset code, from the datasets built into
+  the program (see datasets.h) and those registered in a manifest file.
+
+  A manifest is a JSON file listing more datasets, so that datasets can be
+  added without recompiling, e.g.
+
+    {
+      "datasets": [
+        {
+          "code": "trains",
+          "name": "Rail passenger journeys",
+          "file": "tran0152.json",
+          "parser": "WelshStatsJSON",
+          "cols": {
+            "AUTH_CODE": "LocalAuthority_Code",
+            "AUTH_NAME_ENG": "LocalAuthority_ItemName_ENG",
+            "YEAR": "Year_Code",
+            "VALUE": "Data",
+            "SINGLE_MEASURE_CODE": "rail",
+            "SINGLE_MEASURE_NAME": "Rail passenger journeys"
+          }
+        }
+      ]
+    }
+
+  where "parser" is the name of a BethYw::SourceDataType and the keys of
+  "cols" are the names of BethYw::SourceColumn values.
+
+  The manifest is only read when a dataset is looked up that is not built
+  in (or every dataset is listed), and the InputFileSource of a dataset in it
+  is only created when that dataset is looked up. If a code is registered
+  more than once, the first registration is used, and the built-in datasets
+  come first.
+ */
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "datasets.h"
+
+class DatasetRegistry {
+private:
+  std::string manifestPath;
+  bool manifestRequired;
+  bool manifestLoaded;
+
+  // The codes of the datasets, in the order they were registered
+  std::vector<std::string> codes;
+
+  // The datasets that have been looked up (or are built in), and the
+  // manifest entries of those that have not been looked up yet
+  std::unordered_map<std::string, const BethYw::InputFileSource *> sources;
+  std::unordered_map<std::string, std::string> entries;
+  std::vector<std::unique_ptr<BethYw::InputFileSource>> created;
+
+  void loadManifest();
+  static std::unique_ptr<BethYw::InputFileSource> parseEntry(const std::string &entry);
+
+public:
+  DatasetRegistry(const std::string &manifestPath = "", bool manifestRequired = false);
+
+  const BethYw::InputFileSource *find(const std::string &code);
+  const BethYw::InputFileSource &at(const std::string &code);
+  const std::vector<std::string> &getCodes();
+};
+
+#endif // REGISTRY_H_
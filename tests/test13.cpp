@@ -0,0 +1,271 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../jsonindex.h"
+#include "../jsonscan.h"
+
+SCENARIO( "StatsWales JSON files are imported identically by every JSON backend", "[Areas][JSONBackend]" ) {
+
+  auto import = [](const BethYw::InputFileSource &source, JSONBackend backend,
+                   const StringFilterSet &areasFilter,
+                   const StringFilterSet &measuresFilter,
+                   const YearFilterTuple &yearsFilter) {
+    std::ifstream stream("datasets/" + source.FILE);
+    REQUIRE( stream.is_open() );
+
+    Areas areas = Areas();
+    areas.setJSONBackend(backend);
+    areas.populateFromWelshStatsJSON(stream, source.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+    return areas.toJSON();
+  };
+
+  GIVEN( "each of the StatsWales JSON datasets" ) {
+
+    for (const auto &source : BethYw::InputFiles::DATASETS) {
+      if (source.PARSER != BethYw::WelshStatsJSON) {
+        continue;
+      }
+
+      AND_GIVEN( "the " + source.CODE + " dataset with no filters" ) {
+
+        StringFilterSet areasFilter(0);
+        StringFilterSet measuresFilter(0);
+        YearFilterTuple yearsFilter = std::make_tuple(0, 0);
+
+        THEN( "the SAX, Scan and SIMD backends import the same data as the DOM backend" ) {
+
+          auto expected = import(source, JSONBackend::DOM, areasFilter, measuresFilter, yearsFilter);
+          REQUIRE( expected != "{}" );
+          REQUIRE( import(source, JSONBackend::SAX, areasFilter, measuresFilter, yearsFilter) == expected );
+          REQUIRE( import(source, JSONBackend::Scan, areasFilter, measuresFilter, yearsFilter) == expected );
+          REQUIRE( import(source, JSONBackend::SIMD, areasFilter, measuresFilter, yearsFilter) == expected );
+
+        } // THEN
+
+      } // AND_GIVEN
+
+      AND_GIVEN( "the " + source.CODE + " dataset with area and year filters" ) {
+
+        StringFilterSet areasFilter{"W06000011", "W06000024"};
+        StringFilterSet measuresFilter(0);
+        YearFilterTuple yearsFilter = std::make_tuple(2010, 2015);
+
+        THEN( "the SAX, Scan and SIMD backends import the same data as the DOM backend" ) {
+
+          auto expected = import(source, JSONBackend::DOM, areasFilter, measuresFilter, yearsFilter);
+          REQUIRE( import(source, JSONBackend::SAX, areasFilter, measuresFilter, yearsFilter) == expected );
+          REQUIRE( import(source, JSONBackend::Scan, areasFilter, measuresFilter, yearsFilter) == expected );
+          REQUIRE( import(source, JSONBackend::SIMD, areasFilter, measuresFilter, yearsFilter) == expected );
+
+        } // THEN
+
+      } // AND_GIVEN
+
+      AND_GIVEN( "the " + source.CODE + " dataset with measure and year filters that exclude most records" ) {
+
+        StringFilterSet areasFilter(0);
+        StringFilterSet measuresFilter{"pop", "rail", "no2", "a"};
+        YearFilterTuple yearsFilter = std::make_tuple(1990, 2003);
+
+        THEN( "the SAX, Scan and SIMD backends import the same data as the DOM backend" ) {
+
+          auto expected = import(source, JSONBackend::DOM, areasFilter, measuresFilter, yearsFilter);
+          REQUIRE( import(source, JSONBackend::SAX, areasFilter, measuresFilter, yearsFilter) == expected );
+          REQUIRE( import(source, JSONBackend::Scan, areasFilter, measuresFilter, yearsFilter) == expected );
+          REQUIRE( import(source, JSONBackend::SIMD, areasFilter, measuresFilter, yearsFilter) == expected );
+
+        } // THEN
+
+      } // AND_GIVEN
+
+    }
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a JSONScanner reads the same values whatever the block size of the stream", "[JSONScanner]" ) {
+
+  auto scan = [](JSONScanner &scanner) {
+    std::string key, value, all;
+    REQUIRE( scanner.findArray("value") );
+    while (scanner.nextObject()) {
+      while (scanner.nextKey(key)) {
+        if (key.find("_SortOrder") != std::string::npos) {
+          scanner.skipValue();
+        } else {
+          scanner.readValue(value);
+          all += key + "=" + value + ";";
+        }
+      }
+      all += "\n";
+    }
+    return all;
+  };
+
+  GIVEN( "the popu1009.json file in memory" ) {
+
+    std::ifstream stream("datasets/popu1009.json");
+    REQUIRE( stream.is_open() );
+    std::string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    JSONScanner memory(contents.data(), contents.data() + contents.size());
+    const std::string expected = scan(memory);
+
+    THEN( "the values read from a stream in single bytes are the same" ) {
+
+      std::istringstream is(contents);
+      JSONScanner scanner(is, 1);
+      REQUIRE( scan(scanner) == expected );
+
+    } // THEN
+
+    THEN( "the values read from a stream in odd-sized blocks are the same" ) {
+
+      std::istringstream is(contents);
+      JSONScanner scanner(is, 997);
+      REQUIRE( scan(scanner) == expected );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a document containing escaped strings" ) {
+
+    std::istringstream is(R"({"value":[{"a":"x\"y\\zô😀","b":{"c":[1,"}"]},"d":-1.5e3}]})");
+    JSONScanner scanner(is, 3);
+    std::string key, value;
+
+    THEN( "the strings are decoded and nested values skipped" ) {
+
+      REQUIRE( scanner.findArray("value") );
+      REQUIRE( scanner.nextObject() );
+      REQUIRE( scanner.nextKey(key) );
+      REQUIRE( key == "a" );
+      REQUIRE( scanner.readValue(value) );
+      REQUIRE( value == "x\"y\\z\xc3\xb4\xf0\x9f\x98\x80" );
+      REQUIRE( scanner.nextKey(key) );
+      REQUIRE_NOTHROW( scanner.skipValue() );
+      REQUIRE( scanner.nextKey(key) );
+      REQUIRE( key == "d" );
+      REQUIRE_FALSE( scanner.readValue(value) );
+      REQUIRE( value == "-1.5e3" );
+      REQUIRE_FALSE( scanner.nextKey(key) );
+      REQUIRE_FALSE( scanner.nextObject() );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a JSONIndexScanner reads the same values as a JSONScanner", "[JSONIndexScanner]" ) {
+
+  auto scan = [](auto &scanner) {
+    std::string key, value, all;
+    REQUIRE( scanner.findArray("value") );
+    while (scanner.nextObject()) {
+      while (scanner.nextKey(key)) {
+        if (key.find("_SortOrder") != std::string::npos) {
+          scanner.skipValue();
+        } else {
+          all += (scanner.readValue(value) ? "s:" : "l:") + key + "=" + value + ";";
+        }
+      }
+      all += "\n";
+    }
+    return all;
+  };
+
+  GIVEN( "the envi0201.json file in memory" ) {
+
+    std::ifstream stream("datasets/envi0201.json");
+    REQUIRE( stream.is_open() );
+    std::string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    JSONScanner reference(contents.data(), contents.data() + contents.size());
+    const std::string expected = scan(reference);
+    const std::string original = JSONIndexScanner::implementation();
+
+    THEN( "the values read using each supported instruction set are the same" ) {
+
+      for (const std::string implementation : {"scalar", "SSE2", "AVX2"}) {
+        if (!JSONIndexScanner::setImplementation(implementation)) {
+          continue;
+        }
+        REQUIRE( JSONIndexScanner::implementation() == implementation );
+
+        JSONIndexScanner scanner(contents.data(), contents.data() + contents.size());
+        REQUIRE( scan(scanner) == expected );
+      }
+      REQUIRE( JSONIndexScanner::setImplementation(original) );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a document with escaped strings that cross 64-byte blocks" ) {
+
+    std::string document = R"({"skip":")" + std::string(50, 'x') + R"(\\\"{[,:","value":[{"a":"x\"y\\z\u00f4\ud83d\ude00",)"
+                           R"("b":{"c":[1,"}"]},"d":-1.5e3 , "e" : null}]})";
+    JSONIndexScanner scanner(document.data(), document.data() + document.size());
+    std::string key, value;
+
+    THEN( "the strings are decoded and nested values skipped" ) {
+
+      REQUIRE( scanner.findArray("value") );
+      REQUIRE( scanner.nextObject() );
+      REQUIRE( scanner.nextKey(key) );
+      REQUIRE( key == "a" );
+      REQUIRE( scanner.readValue(value) );
+      REQUIRE( value == "x\"y\\z\xc3\xb4\xf0\x9f\x98\x80" );
+      REQUIRE( scanner.nextKey(key) );
+      REQUIRE_NOTHROW( scanner.skipValue() );
+      REQUIRE( scanner.nextKey(key) );
+      REQUIRE( key == "d" );
+      REQUIRE_FALSE( scanner.readValue(value) );
+      REQUIRE( value == "-1.5e3" );
+      REQUIRE( scanner.nextKey(key) );
+      REQUIRE( key == "e" );
+      REQUIRE_FALSE( scanner.readValue(value) );
+      REQUIRE( value == "null" );
+      REQUIRE_FALSE( scanner.nextKey(key) );
+      REQUIRE_FALSE( scanner.nextObject() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a document with an unterminated string" ) {
+
+    std::string document = R"({"value":[{"a":"x}]})";
+
+    THEN( "a std::runtime_error is thrown" ) {
+
+      REQUIRE_THROWS_AS( JSONIndexScanner(document.data(), document.data() + document.size()), std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
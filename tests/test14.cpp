@@ -0,0 +1,247 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../datasets.h"
+#include "../jsonscan.h"
+#include "../numeric.h"
+
+/*
+  Returns true if std::stod would read str as a hexadecimal number, which
+  BethYw::decodeDouble() does not support.
+*/
+static bool isHexadecimal(const std::string &str) {
+  std::size_t i = str.find_first_not_of(" \t\n\v\f\r+-");
+  return i != std::string::npos && str.compare(i, 2, "0x") == 0;
+}
+
+/*
+  Returns a description of how BethYw::decodeDouble() differs from std::stod
+  for str, or an empty string if they agree bit for bit.
+*/
+static std::string compareDouble(const std::string &str) {
+  double expected = 0;
+  bool valid = true;
+  try {
+    expected = std::stod(str);
+  } catch (const std::logic_error &e) {
+    valid = false;
+  }
+
+  double actual = 0;
+  bool decoded = BethYw::decodeDouble(str, actual);
+
+  if (valid && (!std::isfinite(expected) || isHexadecimal(str))) {
+    return "";
+  } else if (valid != decoded) {
+    return str + (decoded ? " was decoded" : " was not decoded");
+  } else if (valid && std::memcmp(&expected, &actual, sizeof(double)) != 0) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), " decoded as %a, not %a", actual, expected);
+    return str + buffer;
+  }
+  return "";
+}
+
+/*
+  Returns a description of how BethYw::decodeInt() differs from std::stoi for
+  str, or an empty string if they agree.
+*/
+static std::string compareInt(const std::string &str) {
+  int expected = 0;
+  bool valid = true;
+  try {
+    expected = std::stoi(str);
+  } catch (const std::logic_error &e) {
+    valid = false;
+  }
+
+  int actual = 0;
+  bool decoded = BethYw::decodeInt(str, actual);
+
+  if (valid != decoded) {
+    return str + (decoded ? " was decoded" : " was not decoded");
+  } else if (valid && expected != actual) {
+    return str + " decoded as " + std::to_string(actual);
+  }
+  return "";
+}
+
+/*
+  Returns every value in a StatsWales JSON file, and every cell of a CSV
+  file.
+*/
+static std::vector<std::string> readValues(const std::string &file) {
+  std::ifstream stream("datasets/" + file);
+  REQUIRE( stream.is_open() );
+
+  std::vector<std::string> values;
+  if (file.substr(file.size() - 4) == ".csv") {
+    std::string line, cell;
+    while (std::getline(stream, line)) {
+      std::stringstream ss(line);
+      while (std::getline(ss, cell, ',')) {
+        values.push_back(cell);
+      }
+    }
+  } else {
+    JSONScanner scanner(stream);
+    std::string key, value;
+    REQUIRE( scanner.findArray("value") );
+    while (scanner.nextObject()) {
+      while (scanner.nextKey(key)) {
+        scanner.readValue(value);
+        values.push_back(value);
+      }
+    }
+  }
+  return values;
+}
+
+SCENARIO( "numbers are decoded exactly as std::stod and std::stoi decode them", "[numeric]" ) {
+
+  GIVEN( "every value in the datasets" ) {
+
+    std::vector<std::string> files = {"areas.csv"};
+    for (const auto &source : BethYw::InputFiles::DATASETS) {
+      files.push_back(source.FILE);
+    }
+
+    THEN( "BethYw::decodeDouble() and BethYw::decodeInt() agree with std::stod and std::stoi" ) {
+
+      std::size_t checked = 0;
+      std::vector<std::string> differences;
+      for (const auto &file : files) {
+        for (const auto &value : readValues(file)) {
+          for (const auto &difference : {compareDouble(value), compareInt(value)}) {
+            if (!difference.empty()) {
+              differences.push_back(file + ": " + difference);
+            }
+          }
+          checked++;
+        }
+      }
+
+      REQUIRE( checked > 10000 );
+      REQUIRE( differences.empty() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "numbers at the edges of the decoding rules" ) {
+
+    const std::vector<std::string> values = {
+      "0", "-0", "+0", "0.0", "-0.0", ".5", "5.", ".", "-", "+", "", "e5",
+      "1e", "1e+", "1e-", "1E5", "1e+5", "1e-5", " \t\n7.25", "7.25xyz",
+      "2015-16", "0001", "00.0001", "1.0000000000000000000000000001",
+      "9007199254740992", "9007199254740993", "9007199254740993.0000000001",
+      "12345678901234567890", "123456789012345678901234567890",
+      "0.1", "0.2", "0.3", "1e22", "1e23", "12e30", "9007199254740991e22",
+      "1.7976931348623157e308", "1.7976931348623159e308", "1e309", "-1e309",
+      "2.2250738585072014e-308", "2.2250738585072011e-308", "4.9e-324",
+      "1e-400", "0e-400", "0e400", "2.4703282292062327e-324",
+      "7.7399419676118376", "2147483647", "2147483648", "-2147483648",
+      "-2147483649", "99999999999999999999", "inf", "nan", "Infinity",
+      "0x1A", "W06000011", "null", "true"
+    };
+
+    THEN( "BethYw::decodeDouble() and BethYw::decodeInt() agree with std::stod and std::stoi" ) {
+
+      std::vector<std::string> differences;
+      for (const auto &value : values) {
+        for (const auto &difference : {compareDouble(value), compareInt(value)}) {
+          if (!difference.empty()) {
+            differences.push_back(difference);
+          }
+        }
+      }
+
+      REQUIRE( differences.empty() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "randomly generated numbers" ) {
+
+    std::mt19937_64 random(690826);
+
+    THEN( "BethYw::decodeDouble() agrees with std::stod for the shortest and longest forms of random doubles" ) {
+
+      std::vector<std::string> differences;
+      for (int i = 0; i < 20000; i++) {
+        std::uint64_t bits = random();
+        double value;
+        std::memcpy(&value, &bits, sizeof(double));
+        if (!std::isfinite(value)) {
+          continue;
+        }
+
+        char buffer[64];
+        for (const char *format : {"%.17g", "%.15g", "%.6e", "%.3f"}) {
+          std::snprintf(buffer, sizeof(buffer), format, value);
+          std::string difference = compareDouble(buffer);
+          if (!difference.empty()) {
+            differences.push_back(difference);
+          }
+        }
+      }
+
+      REQUIRE( differences.empty() );
+
+    } // THEN
+
+    THEN( "BethYw::decodeDouble() agrees with std::stod for random decimal numbers" ) {
+
+      std::vector<std::string> differences;
+      for (int i = 0; i < 50000; i++) {
+        std::string str = random() % 2 ? "-" : "";
+        int digits = 1 + random() % 25;
+        int point = random() % (digits + 1);
+        for (int d = 0; d < digits; d++) {
+          if (d == point) {
+            str += '.';
+          }
+          str += static_cast<char>('0' + random() % 10);
+        }
+        if (random() % 2) {
+          str += "e" + std::to_string(static_cast<int>(random() % 80) - 40);
+        }
+
+        std::string difference = compareDouble(str);
+        if (!difference.empty()) {
+          differences.push_back(difference);
+        }
+      }
+
+      REQUIRE( differences.empty() );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
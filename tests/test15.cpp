@@ -0,0 +1,162 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "../datasets.h"
+#include "../areas.h"
+
+SCENARIO( "a StatsWales JSON file is imported identically on several threads", "[Areas][threads]" ) {
+
+  auto import = [](std::istream &is, JSONBackend backend, unsigned int threads,
+                   const BethYw::SourceColumnMapping &cols,
+                   const StringFilterSet &areasFilter,
+                   const StringFilterSet &measuresFilter,
+                   const YearFilterTuple &yearsFilter) {
+    // Some areas already exist, as they would after areas.csv is imported
+    std::ifstream areasStream("datasets/areas.csv");
+    REQUIRE( areasStream.is_open() );
+
+    Areas areas = Areas();
+    areas.populateFromAuthorityCodeCSV(areasStream, BethYw::InputFiles::AREAS.COLS);
+    areas.setJSONBackend(backend);
+    areas.setThreads(threads);
+    areas.populateFromWelshStatsJSON(is, cols, &areasFilter, &measuresFilter, &yearsFilter);
+    return areas.toJSON();
+  };
+
+  GIVEN( "each of the StatsWales JSON datasets" ) {
+
+    for (const auto &source : BethYw::InputFiles::DATASETS) {
+      if (source.PARSER != BethYw::WelshStatsJSON) {
+        continue;
+      }
+
+      std::ifstream stream("datasets/" + source.FILE);
+      REQUIRE( stream.is_open() );
+      const std::string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+      auto importFile = [&](JSONBackend backend, unsigned int threads,
+                            const StringFilterSet &areasFilter,
+                            const StringFilterSet &measuresFilter,
+                            const YearFilterTuple &yearsFilter) {
+        std::istringstream is(contents);
+        return import(is, backend, threads, source.COLS, areasFilter, measuresFilter, yearsFilter);
+      };
+
+      AND_GIVEN( "the " + source.CODE + " dataset with no filters" ) {
+
+        StringFilterSet areasFilter(0);
+        StringFilterSet measuresFilter(0);
+        YearFilterTuple yearsFilter = std::make_tuple(0, 0);
+
+        THEN( "the data imported on 2, 3 and 8 threads is the same as on one" ) {
+
+          auto expected = importFile(JSONBackend::Scan, 1, areasFilter, measuresFilter, yearsFilter);
+          for (unsigned int threads : {2, 3, 8}) {
+            REQUIRE( importFile(JSONBackend::Scan, threads, areasFilter, measuresFilter, yearsFilter) == expected );
+            REQUIRE( importFile(JSONBackend::SIMD, threads, areasFilter, measuresFilter, yearsFilter) == expected );
+          }
+
+        } // THEN
+
+      } // AND_GIVEN
+
+      AND_GIVEN( "the " + source.CODE + " dataset with area, measure and year filters" ) {
+
+        StringFilterSet areasFilter{"W06000011", "W06000024", "W92000004"};
+        StringFilterSet measuresFilter{"pop", "rail", "no2", "a", "pm10"};
+        YearFilterTuple yearsFilter = std::make_tuple(2005, 2015);
+
+        THEN( "the data imported on 4 threads is the same as on one" ) {
+
+          auto expected = importFile(JSONBackend::Scan, 1, areasFilter, measuresFilter, yearsFilter);
+          REQUIRE( importFile(JSONBackend::Scan, 4, areasFilter, measuresFilter, yearsFilter) == expected );
+          REQUIRE( importFile(JSONBackend::SIMD, 4, areasFilter, measuresFilter, yearsFilter) == expected );
+
+        } // THEN
+
+      } // AND_GIVEN
+
+    }
+
+  } // GIVEN
+
+  GIVEN( "a large generated file where later records override earlier ones" ) {
+
+    // Areas are named after the first record for them, and values are
+    // overwritten by each later record for the same area, measure and year
+    auto generate = [](const std::string &namePrefix) {
+      std::string document = R"({"odata.metadata":"x","value":[)";
+      for (int i = 0; i < 20000; i++) {
+        std::string code = "W060000" + std::to_string(10 + i * 7 % 30);
+        std::string measure = "P" + std::to_string(i % 5);
+        document += std::string(i == 0 ? "" : ",\n  ") +
+                    R"({"Area_Code":")" + code + R"(","Area_ItemName_ENG":")" +
+                    namePrefix + std::to_string(i) + R"(","Pollutant_ItemName_ENG":")" +
+                    measure + R"(","Year_Code":")" + std::to_string(2000 + i % 10) +
+                    R"(","Data":)" + std::to_string(i) + "}";
+      }
+      return document + R"(],"odata.nextLink":"y"})";
+    };
+
+    StringFilterSet areasFilter(0);
+    StringFilterSet measuresFilter(0);
+    YearFilterTuple yearsFilter = std::make_tuple(0, 0);
+
+    auto importDocument = [&](const std::string &document, JSONBackend backend, unsigned int threads) {
+      std::istringstream is(document);
+      return import(is, backend, threads, BethYw::InputFiles::AQI.COLS, areasFilter, measuresFilter, yearsFilter);
+    };
+
+    THEN( "the data imported on 4 threads is the same as on one" ) {
+
+      std::string document = generate("Area ");
+      auto expected = importDocument(document, JSONBackend::Scan, 1);
+      REQUIRE( importDocument(document, JSONBackend::Scan, 4) == expected );
+      REQUIRE( importDocument(document, JSONBackend::SIMD, 4) == expected );
+
+    } // THEN
+
+    THEN( "the data imported on 4 threads is the same as on one when strings look like the end of a record" ) {
+
+      std::string namePrefix;
+      for (int i = 0; i < 20; i++) {
+        namePrefix += "Area }, {";
+      }
+      std::string document = generate(namePrefix);
+      auto expected = importDocument(document, JSONBackend::Scan, 1);
+      REQUIRE( importDocument(document, JSONBackend::Scan, 4) == expected );
+      REQUIRE( importDocument(document, JSONBackend::SIMD, 4) == expected );
+
+    } // THEN
+
+    THEN( "a std::runtime_error is thrown for a truncated file on 4 threads" ) {
+
+      std::string document = generate("Area ");
+      document.resize(document.rfind("\"Data\":") + 7);
+      REQUIRE_THROWS_AS( importDocument(document, JSONBackend::Scan, 4), std::runtime_error );
+      REQUIRE_THROWS_AS( importDocument(document, JSONBackend::SIMD, 4), std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
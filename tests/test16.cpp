@@ -0,0 +1,138 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../lib_json.hpp"
+#include "../datasets.h"
+#include "../areas.h"
+#include "../input.h"
+
+SCENARIO( "a dataset split into linked pages can be imported with InputPages", "[InputPages]" ) {
+
+  const std::string link = "http://localhost/en-gb/dataset/envi0201?%24skiptoken=";
+
+  // Split the records of envi0201.json into three pages, written to the
+  // current directory, where each page links to the next
+  std::ifstream stream("datasets/envi0201.json");
+  REQUIRE( stream.is_open() );
+  nlohmann::json original;
+  stream >> original;
+
+  const auto &records = original["value"];
+  std::vector<std::string> paths = {"test16-envi0201.json",
+                                    InputPages::pageFileName(link + "1"),
+                                    InputPages::pageFileName(link + "2")};
+
+  auto writePages = [&](const std::vector<std::string> &links) {
+    for (std::size_t i = 0; i < paths.size(); i++) {
+      nlohmann::json page;
+      page["odata.metadata"] = original["odata.metadata"];
+      page["value"] = nlohmann::json::array();
+      for (std::size_t j = i * records.size() / 3; j < (i + 1) * records.size() / 3; j++) {
+        page["value"].push_back(records[j]);
+      }
+      if (!links.at(i).empty()) {
+        page["odata.nextLink"] = links.at(i);
+      }
+
+      std::ofstream out(paths.at(i));
+      out << page.dump(2);
+    }
+  };
+
+  auto importPages = [&](Areas &areas) {
+    InputPages pages(paths.front(), "");
+    std::istream &is = pages.open();
+    int count = 0;
+    do {
+      areas.populate(is, BethYw::WelshStatsJSON, BethYw::InputFiles::AQI.COLS);
+      count++;
+    } while (pages.next());
+    return count;
+  };
+
+  GIVEN( "three pages that link to each other in turn" ) {
+
+    writePages({link + "1", link + "2", ""});
+
+    THEN( "importing every page gives the same data as the records all in one file" ) {
+
+      std::ifstream whole("datasets/envi0201.json");
+      REQUIRE( whole.is_open() );
+      Areas expected = Areas();
+      expected.populate(whole, BethYw::WelshStatsJSON, BethYw::InputFiles::AQI.COLS);
+
+      for (JSONBackend backend : {JSONBackend::Scan, JSONBackend::SIMD, JSONBackend::SAX, JSONBackend::DOM}) {
+        Areas areas = Areas();
+        areas.setJSONBackend(backend);
+        REQUIRE( importPages(areas) == 3 );
+        REQUIRE( areas.toJSON() == expected.toJSON() );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "three pages where the last links back to the second" ) {
+
+    writePages({link + "1", link + "2", link + "1"});
+
+    THEN( "each page is only imported once" ) {
+
+      Areas areas = Areas();
+      REQUIRE( importPages(areas) == 3 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a page that links to a page that does not exist" ) {
+
+    writePages({link + "1", link + "3", ""});
+
+    THEN( "a std::runtime_error is thrown when moving on to the missing page" ) {
+
+      InputPages pages(paths.front(), "");
+      REQUIRE_NOTHROW( pages.open() );
+      REQUIRE( pages.next() );
+      REQUIRE_THROWS_AS( pages.next(), std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "the name of the local copy of a StatsWales page" ) {
+
+    THEN( "it is made from the last segment of the link and its query" ) {
+
+      REQUIRE( InputPages::pageFileName("http://open.statswales.gov.wales/en-gb/dataset/envi0201?%24skiptoken=1!24|2") ==
+               "envi0201__24skiptoken_1_24_2.json" );
+      REQUIRE( InputPages::pageFileName("envi0201") == "envi0201.json" );
+
+    } // THEN
+
+  } // GIVEN
+
+  for (const auto &path : paths) {
+    std::remove(path.c_str());
+  }
+
+} // SCENARIO
@@ -0,0 +1,249 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../csvscan.h"
+
+/*
+  Returns every row of a CSV document, read with the given block size.
+*/
+static std::vector<std::vector<std::string>> scanCSV(const std::string &document,
+                                                     std::size_t blockSize) {
+  std::istringstream is(document);
+  CSVScanner scanner(is, blockSize);
+
+  std::vector<std::vector<std::string>> rows;
+  while (scanner.nextRow()) {
+    std::vector<std::string> row;
+    for (std::size_t i = 0; i < scanner.size(); i++) {
+      row.push_back(scanner[i].str());
+    }
+    rows.push_back(row);
+  }
+  return rows;
+}
+
+SCENARIO( "a CSV file can be split into rows and fields", "[CSVScanner]" ) {
+
+  GIVEN( "a CSV file with quoted fields" ) {
+
+    const std::string document =
+        "Local Authority Code,Name (eng),Name (cym)\r\n"
+        "W06000011,\"Swansea, City and County\",\"Abertawe\"\r\n"
+        "\r\n"
+        "W06000024,\"Merthyr \"\"Tydfil\"\"\",\"Merthyr\nTudful\"\n"
+        "W06000999,,\n"
+        "\"\",last";
+
+    const std::vector<std::vector<std::string>> expected = {
+      {"Local Authority Code", "Name (eng)", "Name (cym)"},
+      {"W06000011", "Swansea, City and County", "Abertawe"},
+      {"W06000024", "Merthyr \"Tydfil\"", "Merthyr\nTudful"},
+      {"W06000999", "", ""},
+      {"", "last"}
+    };
+
+    THEN( "the fields are unquoted and blank rows are skipped, whatever the block size" ) {
+
+      for (std::size_t blockSize : {1, 2, 7, 64, 65536}) {
+        REQUIRE( scanCSV(document, blockSize) == expected );
+      }
+
+    } // THEN
+
+    THEN( "CSVScanner::at() throws std::out_of_range for a field past the end of a row" ) {
+
+      std::istringstream is(document);
+      CSVScanner scanner(is);
+      REQUIRE( scanner.nextRow() );
+      REQUIRE( scanner.at(2) == "Name (cym)" );
+      REQUIRE_THROWS_AS( scanner.at(3), std::out_of_range );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a CSV file with rows longer than a 64-byte block" ) {
+
+    std::string document;
+    std::vector<std::vector<std::string>> expected;
+    for (int i = 0; i < 50; i++) {
+      std::vector<std::string> row;
+      for (int j = 0; j <= i; j++) {
+        row.push_back(j % 3 == 0 ? "\"" + std::to_string(i * j) + ",\"" : std::to_string(i * j));
+        document += (j == 0 ? "" : ",") + row.back();
+        if (j % 3 == 0) {
+          row.back() = std::to_string(i * j) + ",";
+        }
+      }
+      document += "\n";
+      expected.push_back(row);
+    }
+
+    THEN( "the rows are read correctly whatever the block size" ) {
+
+      for (std::size_t blockSize : {1, 5, 64, 100, 65536}) {
+        REQUIRE( scanCSV(document, blockSize) == expected );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a CSV file ending inside a quoted field" ) {
+
+    THEN( "a std::runtime_error is thrown" ) {
+
+      REQUIRE_THROWS_AS( scanCSV("a,b\n\"c,d\n", 65536), std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "the CSV datasets" ) {
+
+    std::vector<std::string> files = {"areas.csv"};
+    for (const auto &source : BethYw::InputFiles::DATASETS) {
+      if (source.PARSER == BethYw::AuthorityByYearCSV) {
+        files.push_back(source.FILE);
+      }
+    }
+
+    THEN( "CSVScanner reads the same fields as splitting each line at commas" ) {
+
+      for (const auto &file : files) {
+        std::ifstream stream("datasets/" + file);
+        REQUIRE( stream.is_open() );
+        const std::string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+        std::vector<std::vector<std::string>> expected;
+        std::istringstream lines(contents);
+        std::string line, cell;
+        while (std::getline(lines, line)) {
+          std::vector<std::string> row;
+          std::istringstream cells(line);
+          while (std::getline(cells, cell, ',')) {
+            row.push_back(cell);
+          }
+          expected.push_back(row);
+        }
+
+        REQUIRE( scanCSV(contents, 65536) == expected );
+        REQUIRE( scanCSV(contents, 13) == expected );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "areas.csv with quoted names" ) {
+
+    std::istringstream is(
+        "Local Authority Code,Name (eng),Name (cym)\n"
+        "W06000011,\"Swansea, City and County\",Abertawe\r\n");
+
+    THEN( "the names are imported without the quotes" ) {
+
+      Areas areas = Areas();
+      areas.populateFromAuthorityCodeCSV(is, BethYw::InputFiles::AREAS.COLS);
+      REQUIRE( areas.getArea("W06000011").getName("eng") == "Swansea, City and County" );
+      REQUIRE( areas.getArea("W06000011").getName("cym") == "Abertawe" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "an authority by year CSV file is imported through a column plan", "[Areas][CSVScanner]" ) {
+
+  GIVEN( "a CSV file with a short row" ) {
+
+    const std::string document =
+        "AuthorityCode,2010,2011,2012,2013\n"
+        "W06000011,1.5,2.5,3.5,4.5\n"
+        "W06000024,10,20\n";
+
+    auto import = [&](const YearFilterTuple &yearsFilter) {
+      std::istringstream is(document);
+      StringFilterSet areasFilter(0);
+      StringFilterSet measuresFilter(0);
+      Areas areas = Areas();
+      areas.populateFromAuthorityByYearCSV(is, BethYw::InputFiles::COMPLETE_POPDEN.COLS,
+                                           &areasFilter, &measuresFilter, &yearsFilter);
+      return areas;
+    };
+
+    THEN( "only the values for the years in the filter are imported" ) {
+
+      Areas areas = import(std::make_tuple(2011, 2012));
+      Measure &swansea = areas.getArea("W06000011").getMeasure("dens");
+      REQUIRE( swansea.size() == 2 );
+      REQUIRE( swansea.getValue(2011) == 2.5 );
+      REQUIRE( swansea.getValue(2012) == 3.5 );
+      REQUIRE( swansea.getLabel() == "Population density" );
+
+      Measure &merthyr = areas.getArea("W06000024").getMeasure("dens");
+      REQUIRE( merthyr.size() == 1 );
+      REQUIRE( merthyr.getValue(2011) == 20 );
+
+    } // THEN
+
+    THEN( "no area is created for a row with no values for the years in the filter" ) {
+
+      Areas areas = import(std::make_tuple(2013, 2020));
+      REQUIRE( areas.size() == 1 );
+      REQUIRE( areas.getArea("W06000011").getMeasure("dens").getValue(2013) == 4.5 );
+
+    } // THEN
+
+    THEN( "nothing is imported when no year is in the filter" ) {
+
+      REQUIRE( import(std::make_tuple(1990, 2000)).size() == 0 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a CSV file with a row longer than the heading" ) {
+
+    std::istringstream is(
+        "AuthorityCode,2010,2011\n"
+        "W06000011,1.5,2.5,3.5\n");
+
+    THEN( "a std::out_of_range exception is thrown" ) {
+
+      StringFilterSet areasFilter(0);
+      StringFilterSet measuresFilter(0);
+      YearFilterTuple yearsFilter = std::make_tuple(0, 0);
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populateFromAuthorityByYearCSV(is, BethYw::InputFiles::COMPLETE_POPDEN.COLS,
+                                                               &areasFilter, &measuresFilter, &yearsFilter),
+                         std::out_of_range );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
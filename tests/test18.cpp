@@ -0,0 +1,141 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../input.h"
+
+SCENARIO( "a file can be memory-mapped", "[InputMappedFile]" ) {
+
+  GIVEN( "each of the datasets" ) {
+
+    std::vector<BethYw::InputFileSource> sources = {BethYw::InputFiles::AREAS};
+    for (const auto &source : BethYw::InputFiles::DATASETS) {
+      sources.push_back(source);
+    }
+
+    for (const auto &source : sources) {
+
+      std::ifstream stream("datasets/" + source.FILE, std::ios::binary);
+      REQUIRE( stream.is_open() );
+      const std::string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+      AND_GIVEN( "the file " + source.FILE ) {
+
+        InputMappedFile input("datasets/" + source.FILE);
+
+        THEN( "the contents of the file are the same as read through a std::ifstream" ) {
+
+          REQUIRE( std::string(input.data(), input.size()) == contents );
+
+          std::istream &is = input.open();
+          REQUIRE( std::string((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>()) == contents );
+
+        } // THEN
+
+        THEN( "the data imported is the same as from a std::ifstream" ) {
+
+          StringFilterSet areasFilter(0);
+          StringFilterSet measuresFilter(0);
+          YearFilterTuple yearsFilter = std::make_tuple(0, 0);
+
+          for (JSONBackend backend : {JSONBackend::Scan, JSONBackend::SIMD, JSONBackend::SAX}) {
+            for (unsigned int threads : {1, 4}) {
+              std::ifstream expectedStream("datasets/" + source.FILE);
+              Areas expected = Areas();
+              expected.setJSONBackend(backend);
+              expected.setThreads(threads);
+              expected.populate(expectedStream, source.PARSER, source.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+
+              InputMappedFile mapped("datasets/" + source.FILE);
+              std::istream &is = mapped.open();
+              Areas actual = Areas();
+              actual.setJSONBackend(backend);
+              actual.setThreads(threads);
+              actual.populate(is, source.PARSER, source.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+
+              REQUIRE( actual.toJSON() == expected.toJSON() );
+              REQUIRE( is.peek() == std::char_traits<char>::eof() );
+            }
+          }
+
+        } // THEN
+
+      } // AND_GIVEN
+
+    }
+
+  } // GIVEN
+
+  GIVEN( "an empty file" ) {
+
+    const std::string path = "test18-empty.csv";
+    std::ofstream(path).close();
+
+    THEN( "it is opened with no contents" ) {
+
+      InputMappedFile input(path);
+      REQUIRE( input.size() == 0 );
+      REQUIRE( input.open().peek() == std::char_traits<char>::eof() );
+
+    } // THEN
+
+    std::remove(path.c_str());
+
+  } // GIVEN
+
+  GIVEN( "a file that does not exist" ) {
+
+    InputMappedFile input("datasets/doesnotexist.csv");
+
+    THEN( "a std::runtime_error is thrown when it is opened" ) {
+
+      REQUIRE_THROWS_AS( input.open(), std::runtime_error );
+
+    } // THEN
+
+    THEN( "prefetching it does nothing" ) {
+
+      REQUIRE_NOTHROW( InputMappedFile::prefetch("datasets/doesnotexist.csv") );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a file that has been prefetched" ) {
+
+    std::ifstream stream("datasets/popu1009.json", std::ios::binary);
+    REQUIRE( stream.is_open() );
+    const std::string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    REQUIRE_NOTHROW( InputMappedFile::prefetch("datasets/popu1009.json") );
+
+    THEN( "its contents are unchanged when it is opened" ) {
+
+      InputMappedFile input("datasets/popu1009.json");
+      REQUIRE( std::string(input.data(), input.size()) == contents );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,118 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+
+SCENARIO( "datasets are loaded identically on several threads", "[loadDatasets][threads]" ) {
+
+  // Load the datasets as the command line does, returning the data as JSON
+  // followed by anything output to std::cerr
+  auto load = [](const std::string &dir,
+                 const std::vector<BethYw::InputFileSource> &datasets,
+                 JSONBackend backend,
+                 unsigned int threads,
+                 const std::unordered_set<std::string> &areasFilter,
+                 const std::unordered_set<std::string> &measuresFilter,
+                 const std::tuple<unsigned int, unsigned int> &yearsFilter) {
+    std::stringstream errors;
+    std::streambuf *cerr = std::cerr.rdbuf(errors.rdbuf());
+
+    Areas data = Areas();
+    data.setJSONBackend(backend);
+    data.setThreads(threads);
+    BethYw::loadAreas(data, "datasets/", areasFilter);
+    BethYw::loadDatasets(data, dir, datasets, areasFilter, measuresFilter, yearsFilter);
+
+    std::cerr.rdbuf(cerr);
+    return data.toJSON() + "\n" + errors.str();
+  };
+
+  const std::vector<BethYw::InputFileSource> all(BethYw::InputFiles::DATASETS,
+                                                 BethYw::InputFiles::DATASETS + BethYw::InputFiles::NUM_DATASETS);
+
+  GIVEN( "all the datasets" ) {
+
+    THEN( "the data loaded on 2, 4 and 7 threads is the same as on one, with no filters" ) {
+
+      std::unordered_set<std::string> none;
+      auto expected = load("datasets/", all, JSONBackend::Scan, 1, none, none, std::make_tuple(0, 0));
+      for (unsigned int threads : {2, 4, 7}) {
+        REQUIRE( load("datasets/", all, JSONBackend::Scan, threads, none, none, std::make_tuple(0, 0)) == expected );
+      }
+      REQUIRE( load("datasets/", all, JSONBackend::SAX, 4, none, none, std::make_tuple(0, 0)) == expected );
+
+    } // THEN
+
+    THEN( "the data loaded on 3 threads is the same as on one, with filters" ) {
+
+      std::unordered_set<std::string> areasFilter{"W06000011", "W06000024", "W92000004", "E12000001"};
+      std::unordered_set<std::string> measuresFilter{"pop", "rail", "no2", "dens", "area"};
+      auto yearsFilter = std::make_tuple(2005u, 2015u);
+
+      auto expected = load("datasets/", all, JSONBackend::Scan, 1, areasFilter, measuresFilter, yearsFilter);
+      REQUIRE( load("datasets/", all, JSONBackend::Scan, 3, areasFilter, measuresFilter, yearsFilter) == expected );
+      REQUIRE( load("datasets/", all, JSONBackend::SIMD, 3, areasFilter, measuresFilter, yearsFilter) == expected );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "datasets where some cannot be imported" ) {
+
+    // The datasets, where two of the files are replaced by malformed copies
+    std::vector<BethYw::InputFileSource> datasets;
+    std::vector<std::string> malformed;
+    for (unsigned int i = 0; i < BethYw::InputFiles::NUM_DATASETS; i++) {
+      const auto &source = BethYw::InputFiles::DATASETS[i];
+      std::string file = "datasets/" + source.FILE;
+      if (i == 1 || i == 4) {
+        std::ifstream in(file);
+        std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        file = "test19-" + source.FILE;
+        std::ofstream(file) << contents.substr(0, contents.size() / 2) << ",x,y";
+        malformed.push_back(file);
+      }
+      datasets.push_back(BethYw::InputFileSource{source.CODE, source.NAME, file, source.PARSER, source.COLS});
+    }
+
+    THEN( "the same data is loaded, and the same errors are output in the same order" ) {
+
+      std::unordered_set<std::string> none;
+      auto expected = load("", datasets, JSONBackend::Scan, 1, none, none, std::make_tuple(0, 0));
+      REQUIRE( expected.find("Error importing dataset:") != std::string::npos );
+      REQUIRE( load("", datasets, JSONBackend::Scan, 4, none, none, std::make_tuple(0, 0)) == expected );
+
+    } // THEN
+
+    for (const auto &file : malformed) {
+      std::remove(file.c_str());
+    }
+
+  } // GIVEN
+
+} // SCENARIO
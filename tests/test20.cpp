@@ -0,0 +1,333 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../decompress.h"
+#include "../input.h"
+
+#ifdef BETHYW_HAVE_ZLIB
+#include <zlib.h>
+
+/*
+  Returns data compressed in the gzip format.
+*/
+static std::string gzip(const std::string &data) {
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+  REQUIRE( deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK );
+
+  std::string compressed(deflateBound(&stream, data.size()), '\0');
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+  stream.avail_in = data.size();
+  stream.next_out = reinterpret_cast<Bytef *>(&compressed[0]);
+  stream.avail_out = compressed.size();
+  REQUIRE( deflate(&stream, Z_FINISH) == Z_STREAM_END );
+  compressed.resize(stream.total_out);
+  deflateEnd(&stream);
+  return compressed;
+}
+#endif
+
+#ifdef BETHYW_HAVE_ZSTD
+#include <zstd.h>
+
+/*
+  Returns data compressed in the zstd format, as a single frame.
+*/
+static std::string zstd(const std::string &data) {
+  std::string compressed(ZSTD_compressBound(data.size()), '\0');
+  const std::size_t size = ZSTD_compress(&compressed[0], compressed.size(), data.data(), data.size(), 3);
+  REQUIRE_FALSE( ZSTD_isError(size) );
+  compressed.resize(size);
+  return compressed;
+}
+#endif
+
+SCENARIO( "compressed datasets are read as if they were decompressed", "[DecompressBuffer][InputMappedFile]" ) {
+
+  GIVEN( "data that is not compressed" ) {
+
+    THEN( "it is not detected as compressed" ) {
+
+      const std::string data = "{\"value\":[]}";
+      REQUIRE( DecompressBuffer::detect(data.data(), data.data() + data.size()) == Compression::None );
+      REQUIRE( DecompressBuffer::detect(data.data(), data.data()) == Compression::None );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "data with the magic bytes of zstd" ) {
+
+    const std::string data = "\x28\xb5\x2f\xfd" "abcdefgh";
+
+    THEN( "it is detected as zstd" ) {
+
+      REQUIRE( DecompressBuffer::detect(data.data(), data.data() + data.size()) == Compression::Zstd );
+
+    } // THEN
+
+    THEN( "a std::runtime_error is thrown when it is read, as it is malformed" ) {
+
+      DecompressBuffer buffer(data.data(), data.data() + data.size(), Compression::Zstd);
+      std::istream is(&buffer);
+      is.exceptions(std::ios::badbit);
+      REQUIRE_THROWS_AS( std::string((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>()),
+                         std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+#ifdef BETHYW_HAVE_ZLIB
+  GIVEN( "each of the datasets compressed with gzip" ) {
+
+    std::vector<BethYw::InputFileSource> sources = {BethYw::InputFiles::AREAS};
+    for (const auto &source : BethYw::InputFiles::DATASETS) {
+      sources.push_back(source);
+    }
+
+    for (const auto &source : sources) {
+
+      std::ifstream stream("datasets/" + source.FILE, std::ios::binary);
+      REQUIRE( stream.is_open() );
+      const std::string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+      const std::string compressed = gzip(contents);
+
+      AND_GIVEN( "the file " + source.FILE ) {
+
+        THEN( "it is decompressed to its contents, whatever the block size" ) {
+
+          REQUIRE( DecompressBuffer::detect(compressed.data(), compressed.data() + compressed.size()) == Compression::Gzip );
+          for (std::size_t blockSize : {1000, 256 * 1024}) {
+            DecompressBuffer buffer(compressed.data(), compressed.data() + compressed.size(),
+                                    Compression::Gzip, blockSize, 2);
+            std::istream is(&buffer);
+            REQUIRE( std::string((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>()) == contents );
+          }
+
+        } // THEN
+
+        THEN( "the data imported from it is the same as from the file itself" ) {
+
+          const std::string path = "test20-" + source.FILE;
+          std::ofstream(path, std::ios::binary) << compressed;
+
+          StringFilterSet areasFilter(0);
+          StringFilterSet measuresFilter(0);
+          YearFilterTuple yearsFilter = std::make_tuple(0, 0);
+
+          for (JSONBackend backend : {JSONBackend::Scan, JSONBackend::SIMD, JSONBackend::SAX}) {
+            std::istringstream expectedStream(contents);
+            Areas expected = Areas();
+            expected.setJSONBackend(backend);
+            expected.populate(expectedStream, source.PARSER, source.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+
+            InputMappedFile input(path);
+            REQUIRE( input.getCompression() == Compression::Gzip );
+            Areas actual = Areas();
+            actual.setJSONBackend(backend);
+            actual.populate(input.open(), source.PARSER, source.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+
+            REQUIRE( actual.toJSON() == expected.toJSON() );
+          }
+
+          std::remove(path.c_str());
+
+        } // THEN
+
+      } // AND_GIVEN
+
+    }
+
+  } // GIVEN
+
+  GIVEN( "two gzip files joined together" ) {
+
+    const std::string compressed = gzip("first,part\n") + gzip("second,part\n");
+
+    THEN( "both are decompressed, whatever the block size" ) {
+
+      for (std::size_t blockSize : {1, 5, 256 * 1024}) {
+        DecompressBuffer buffer(compressed.data(), compressed.data() + compressed.size(),
+                                Compression::Gzip, blockSize, 1);
+        std::istream is(&buffer);
+        REQUIRE( std::string((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>()) ==
+                 "first,part\nsecond,part\n" );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a truncated gzip file" ) {
+
+    std::ifstream stream("datasets/popu1009.json", std::ios::binary);
+    const std::string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    const std::string compressed = gzip(contents).substr(0, 5000);
+
+    const std::string path = "test20-truncated.json.gz";
+    std::ofstream(path, std::ios::binary) << compressed;
+
+    THEN( "a std::runtime_error is thrown when it is imported" ) {
+
+      StringFilterSet areasFilter(0);
+      StringFilterSet measuresFilter(0);
+      YearFilterTuple yearsFilter = std::make_tuple(0, 0);
+
+      InputMappedFile input(path);
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populateFromWelshStatsJSON(input.open(), BethYw::InputFiles::DATASETS[0].COLS,
+                                                          &areasFilter, &measuresFilter, &yearsFilter),
+                         std::runtime_error );
+
+    } // THEN
+
+    THEN( "the file can be closed before it has all been read" ) {
+
+      InputMappedFile input(path);
+      char block[100];
+      input.open().read(block, sizeof(block));
+      REQUIRE( input.open().gcount() == sizeof(block) );
+
+    } // THEN
+
+    std::remove(path.c_str());
+
+  } // GIVEN
+#endif
+
+#ifdef BETHYW_HAVE_ZSTD
+  GIVEN( "each of the datasets compressed with zstd" ) {
+
+    std::vector<BethYw::InputFileSource> sources = {BethYw::InputFiles::AREAS};
+    for (const auto &source : BethYw::InputFiles::DATASETS) {
+      sources.push_back(source);
+    }
+
+    for (const auto &source : sources) {
+
+      std::ifstream stream("datasets/" + source.FILE, std::ios::binary);
+      REQUIRE( stream.is_open() );
+      const std::string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+      const std::string compressed = zstd(contents);
+
+      AND_GIVEN( "the file " + source.FILE ) {
+
+        THEN( "it is decompressed to its contents, whatever the block size" ) {
+
+          REQUIRE( DecompressBuffer::detect(compressed.data(), compressed.data() + compressed.size()) == Compression::Zstd );
+          for (std::size_t blockSize : {1000, 256 * 1024}) {
+            DecompressBuffer buffer(compressed.data(), compressed.data() + compressed.size(),
+                                    Compression::Zstd, blockSize, 2);
+            std::istream is(&buffer);
+            REQUIRE( std::string((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>()) == contents );
+          }
+
+        } // THEN
+
+        THEN( "the data imported from it is the same as from the file itself" ) {
+
+          const std::string path = "test20-" + source.FILE + ".zst";
+          std::ofstream(path, std::ios::binary) << compressed;
+
+          StringFilterSet areasFilter(0);
+          StringFilterSet measuresFilter(0);
+          YearFilterTuple yearsFilter = std::make_tuple(0, 0);
+
+          for (JSONBackend backend : {JSONBackend::Scan, JSONBackend::SIMD, JSONBackend::SAX}) {
+            std::istringstream expectedStream(contents);
+            Areas expected = Areas();
+            expected.setJSONBackend(backend);
+            expected.populate(expectedStream, source.PARSER, source.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+
+            InputMappedFile input(path);
+            REQUIRE( input.getCompression() == Compression::Zstd );
+            Areas actual = Areas();
+            actual.setJSONBackend(backend);
+            actual.populate(input.open(), source.PARSER, source.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+
+            REQUIRE( actual.toJSON() == expected.toJSON() );
+          }
+
+          std::remove(path.c_str());
+
+        } // THEN
+
+      } // AND_GIVEN
+
+    }
+
+  } // GIVEN
+
+  GIVEN( "two zstd frames joined together" ) {
+
+    const std::string compressed = zstd("first,part\n") + zstd("second,part\n");
+
+    THEN( "both are decompressed, whatever the block size" ) {
+
+      for (std::size_t blockSize : {1, 5, 256 * 1024}) {
+        DecompressBuffer buffer(compressed.data(), compressed.data() + compressed.size(),
+                                Compression::Zstd, blockSize, 1);
+        std::istream is(&buffer);
+        REQUIRE( std::string((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>()) ==
+                 "first,part\nsecond,part\n" );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a truncated zstd file" ) {
+
+    std::ifstream stream("datasets/popu1009.json", std::ios::binary);
+    const std::string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    const std::string compressed = zstd(contents).substr(0, 5000);
+
+    const std::string path = "test20-truncated.json.zst";
+    std::ofstream(path, std::ios::binary) << compressed;
+
+    THEN( "a std::runtime_error is thrown when it is imported" ) {
+
+      StringFilterSet areasFilter(0);
+      StringFilterSet measuresFilter(0);
+      YearFilterTuple yearsFilter = std::make_tuple(0, 0);
+
+      InputMappedFile input(path);
+      REQUIRE( input.getCompression() == Compression::Zstd );
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populateFromWelshStatsJSON(input.open(), BethYw::InputFiles::DATASETS[0].COLS,
+                                                          &areasFilter, &measuresFilter, &yearsFilter),
+                         std::runtime_error );
+
+    } // THEN
+
+    std::remove(path.c_str());
+
+  } // GIVEN
+#endif
+
+} // SCENARIO
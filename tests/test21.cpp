@@ -0,0 +1,180 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../lib_cxxopts.hpp"
+#include "../lib_cxxopts_argv.hpp"
+
+#include "../datasets.h"
+#include "../bethyw.h"
+#include "../registry.h"
+
+SCENARIO( "datasets can be registered in a manifest", "[DatasetRegistry]" ) {
+
+  const std::string manifestPath = "test21-manifest.json";
+  std::ofstream(manifestPath) << R"({
+    "datasets": [
+      {
+        "code": "rail",
+        "name": "Rail passenger journeys",
+        "file": "tran0152.json",
+        "parser": "WelshStatsJSON",
+        "cols": {
+          "AUTH_CODE": "LocalAuthority_Code",
+          "AUTH_NAME_ENG": "LocalAuthority_ItemName_ENG",
+          "YEAR": "Year_Code",
+          "VALUE": "Data",
+          "SINGLE_MEASURE_CODE": "rail",
+          "SINGLE_MEASURE_NAME": "Rail passenger journeys"
+        }
+      },
+      {
+        "code": "popden",
+        "file": "ignored.json",
+        "parser": "WelshStatsJSON",
+        "cols": {}
+      },
+      {
+        "code": "broken",
+        "file": "broken.csv",
+        "parser": "NotAParser",
+        "cols": {}
+      }
+    ]
+  })";
+
+  GIVEN( "a registry with a manifest" ) {
+
+    DatasetRegistry registry(manifestPath, true);
+
+    THEN( "the built-in datasets are found" ) {
+
+      const BethYw::InputFileSource *source = registry.find("popden");
+      REQUIRE( source != nullptr );
+      REQUIRE( source->FILE == BethYw::InputFiles::POPDEN.FILE );
+
+    } // THEN
+
+    THEN( "the datasets in the manifest are found" ) {
+
+      const BethYw::InputFileSource &source = registry.at("rail");
+      REQUIRE( source.NAME == "Rail passenger journeys" );
+      REQUIRE( source.FILE == "tran0152.json" );
+      REQUIRE( source.PARSER == BethYw::WelshStatsJSON );
+      REQUIRE( source.COLS == BethYw::InputFiles::TRAINS.COLS );
+      REQUIRE( &registry.at("rail") == &source );
+
+    } // THEN
+
+    THEN( "every code is listed, built-in datasets first, and only once" ) {
+
+      std::vector<std::string> expected;
+      for (const auto &source : BethYw::InputFiles::DATASETS) {
+        expected.push_back(source.CODE);
+      }
+      expected.push_back("rail");
+      expected.push_back("broken");
+      REQUIRE( registry.getCodes() == expected );
+
+    } // THEN
+
+    THEN( "a code that is not registered is not found" ) {
+
+      REQUIRE( registry.find("invalid") == nullptr );
+      REQUIRE_THROWS_AS( registry.at("invalid"), std::out_of_range );
+
+    } // THEN
+
+    THEN( "a malformed dataset is only reported when it is looked up" ) {
+
+      REQUIRE_NOTHROW( registry.getCodes() );
+      REQUIRE_THROWS_AS( registry.find("broken"), std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a registry whose manifest does not exist" ) {
+
+    THEN( "the manifest is not read when a built-in dataset is found" ) {
+
+      DatasetRegistry registry("test21-doesnotexist.json", true);
+      REQUIRE( registry.find("trains") != nullptr );
+      REQUIRE_THROWS_AS( registry.find("rail"), std::runtime_error );
+
+    } // THEN
+
+    THEN( "no datasets are added if the manifest is optional" ) {
+
+      DatasetRegistry registry("test21-doesnotexist.json", false);
+      REQUIRE( registry.getCodes().size() == BethYw::InputFiles::NUM_DATASETS );
+      REQUIRE( registry.find("rail") == nullptr );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "the --manifest program argument" ) {
+
+    Argv argv({"test", "--manifest", manifestPath.c_str(), "--datasets", "trains,rail"});
+    auto** actual_argv = argv.argv();
+    auto argc          = argv.argc();
+
+    auto cxxopts = BethYw::cxxoptsSetup();
+    auto args    = cxxopts.parse(argc, actual_argv);
+
+    THEN( "the datasets in the manifest can be imported" ) {
+
+      auto datasets = BethYw::parseDatasetsArg(args);
+      REQUIRE( datasets.size() == 2 );
+      REQUIRE( datasets[0].CODE == "trains" );
+      REQUIRE( datasets[1].CODE == "rail" );
+      REQUIRE( datasets[1].FILE == "tran0152.json" );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a malformed manifest" ) {
+
+    const std::string malformedPath = "test21-malformed.json";
+    std::ofstream(malformedPath) << R"({"datasets": [)";
+
+    Argv argv({"test", "--manifest", malformedPath.c_str(), "--datasets", "rail"});
+    auto** actual_argv = argv.argv();
+    auto argc          = argv.argc();
+
+    auto cxxopts = BethYw::cxxoptsSetup();
+    auto args    = cxxopts.parse(argc, actual_argv);
+
+    THEN( "a std::invalid_argument exception is thrown" ) {
+
+      REQUIRE_THROWS_AS( BethYw::parseDatasetsArg(args), std::invalid_argument );
+
+    } // THEN
+
+    std::remove(malformedPath.c_str());
+
+  } // GIVEN
+
+  std::remove(manifestPath.c_str());
+
+} // SCENARIO
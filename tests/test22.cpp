@@ -0,0 +1,349 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../catalog.h"
+#include "../input.h"
+
+SCENARIO( "the datasets are summarised in a catalog", "[DatasetCatalog]" ) {
+
+  const std::string catalogPath = "test22-catalog.json";
+  std::remove(catalogPath.c_str());
+
+  std::unordered_set<std::string> none;
+
+  // The areas in areas.csv, which are imported before the datasets
+  Areas areas = Areas();
+  BethYw::loadAreas(areas, "datasets/", none);
+
+  GIVEN( "the summaries of the datasets" ) {
+
+    DatasetCatalog catalog(catalogPath);
+    DatasetSummary popden = catalog.summarise("datasets/popu1009.json", BethYw::InputFiles::POPDEN);
+    DatasetSummary biz = catalog.summarise("datasets/econ0080.json", BethYw::InputFiles::BIZ);
+    DatasetSummary pop = catalog.summarise("datasets/complete-popu1009-pop.csv", BethYw::InputFiles::COMPLETE_POP);
+
+    THEN( "they hold the measures, years and areas of the datasets" ) {
+
+      REQUIRE( popden.valid );
+      REQUIRE( popden.measures.size() == 3 );
+      REQUIRE( popden.measures.at("dens") == std::make_pair(1991, 2019) );
+      REQUIRE( popden.areas.size() == 12 );
+      REQUIRE( popden.areas.count("W06000011") == 1 );
+
+      REQUIRE( popden.years == std::make_pair(1991, 2019) );
+      REQUIRE( popden.values == 1000 );
+
+      REQUIRE( pop.valid );
+      REQUIRE( pop.measures.size() == 1 );
+      REQUIRE( pop.measures.at("pop") == std::make_pair(1991, 2019) );
+
+    } // THEN
+
+    THEN( "a JSON dataset without the measures is skipped only if its areas already exist" ) {
+
+      std::unordered_set<std::string> rail{"rail"};
+      auto allYears = std::make_tuple(0u, 0u);
+
+      REQUIRE( popden.canSkip(areas.getAreaContainer(), none, rail, allYears) );
+      REQUIRE_FALSE( popden.canSkip(AreasContainer(), none, rail, allYears) );
+      REQUIRE_FALSE( popden.canSkip(areas.getAreaContainer(), none, {"dens"}, allYears) );
+
+      // econ0080.json has English regions, which are not in areas.csv
+      REQUIRE_FALSE( biz.canSkip(areas.getAreaContainer(), none, rail, allYears) );
+      REQUIRE( biz.canSkip(areas.getAreaContainer(), {"W06000011"}, rail, allYears) );
+
+      // A record creates its measure even if its year is not imported
+      REQUIRE_FALSE( popden.canSkip(areas.getAreaContainer(), none, {"dens"}, std::make_tuple(2030u, 2040u)) );
+
+    } // THEN
+
+    THEN( "a dataset is skipped if none of its areas are accepted" ) {
+
+      std::unordered_set<std::string> areasFilter{"W99999999"};
+      REQUIRE( popden.canSkip(AreasContainer(), areasFilter, none, std::make_tuple(0u, 0u)) );
+      REQUIRE( pop.canSkip(AreasContainer(), areasFilter, none, std::make_tuple(0u, 0u)) );
+      REQUIRE_FALSE( pop.canSkip(AreasContainer(), {"W06000011"}, none, std::make_tuple(0u, 0u)) );
+
+    } // THEN
+
+    THEN( "a JSON dataset is skipped for its years only if its areas and measures already exist" ) {
+
+      Areas imported = Areas();
+      std::ifstream stream("datasets/popu1009.json");
+      imported.populate(stream, BethYw::InputFiles::POPDEN.PARSER, BethYw::InputFiles::POPDEN.COLS);
+
+      REQUIRE( popden.canSkip(imported.getAreaContainer(), none, none, std::make_tuple(2030u, 2040u)) );
+      REQUIRE_FALSE( popden.canSkip(imported.getAreaContainer(), none, none, std::make_tuple(2019u, 2040u)) );
+
+    } // THEN
+
+    THEN( "a CSV dataset is skipped if none of its values can be imported" ) {
+
+      REQUIRE( pop.canSkip(AreasContainer(), none, {"dens"}, std::make_tuple(0u, 0u)) );
+      REQUIRE( pop.canSkip(AreasContainer(), none, {"pop"}, std::make_tuple(2030u, 2040u)) );
+      REQUIRE_FALSE( pop.canSkip(AreasContainer(), none, {"pop"}, std::make_tuple(2015u, 2040u)) );
+
+    } // THEN
+
+    THEN( "the summaries are read back from the catalog file once it is saved" ) {
+
+      catalog.save();
+      DatasetCatalog saved(catalogPath);
+      DatasetSummary read = saved.summarise("datasets/popu1009.json", BethYw::InputFiles::POPDEN);
+      REQUIRE( read.valid );
+      REQUIRE( read.measures == popden.measures );
+      REQUIRE( read.areas == popden.areas );
+      REQUIRE( read.signature == popden.signature );
+
+    } // THEN
+
+    THEN( "a catalog that cannot be written cannot be saved" ) {
+
+      REQUIRE( catalog.canSave() );
+      REQUIRE_FALSE( DatasetCatalog("doesnotexist/" + catalogPath).canSave() );
+
+    } // THEN
+
+    THEN( "each save is written through a temporary file of its own" ) {
+
+      std::string first = temporaryFilePath(catalogPath);
+      std::string second = temporaryFilePath(catalogPath);
+      REQUIRE( first != second );
+      REQUIRE( first.compare(0, catalogPath.size() + 5, catalogPath + ".tmp.") == 0 );
+      REQUIRE( second.compare(0, catalogPath.size() + 5, catalogPath + ".tmp.") == 0 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a pair filter" ) {
+
+    std::vector<std::string> codes;
+    for (int i = 0; i < 1000; i++) {
+      codes.push_back("W" + std::to_string(6000000 + i));
+    }
+
+    PairFilter pairs(codes.size());
+    for (const auto &code : codes) {
+      pairs.add(code, "pop");
+    }
+
+    THEN( "every pair added to it might be in it" ) {
+
+      for (const auto &code : codes) {
+        REQUIRE( pairs.mayContain(code, "pop") );
+      }
+
+    } // THEN
+
+    THEN( "few pairs that were not added to it might be in it" ) {
+
+      unsigned int falsePositives = 0;
+      for (const auto &code : codes) {
+        falsePositives += pairs.mayContain(code, "dens");
+        falsePositives += pairs.mayContain(code + "0", "pop");
+      }
+      REQUIRE( falsePositives < 40 );
+
+    } // THEN
+
+    THEN( "a pair is not confused with one split differently" ) {
+
+      PairFilter pair(1);
+      pair.add("ab", "c");
+      REQUIRE( pair.mayContain("ab", "c") );
+      REQUIRE_FALSE( pair.mayContain("a", "bc") );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a JSON dataset in which an area does not have every measure" ) {
+
+    const std::string path = "test22-pairs.json";
+    std::ofstream(path) << R"({"value": [
+      {"Localauthority_Code": "W06000011", "Localauthority_ItemName_ENG": "Swansea",
+       "Measure_Code": "Pop", "Measure_ItemName_ENG": "Population", "Year_Code": "2011", "Data": 1},
+      {"Localauthority_Code": "W06000024", "Localauthority_ItemName_ENG": "Merthyr Tydfil",
+       "Measure_Code": "Dens", "Measure_ItemName_ENG": "Density", "Year_Code": "2011", "Data": 2}
+    ]})";
+
+    DatasetCatalog catalog(catalogPath);
+    DatasetSummary summary = catalog.summarise(path, BethYw::InputFiles::POPDEN);
+    REQUIRE( summary.valid );
+
+    THEN( "it is skipped for a measure of another area, if its areas exist" ) {
+
+      REQUIRE( summary.canSkip(areas.getAreaContainer(), {"W06000011"}, {"dens"}, std::make_tuple(0u, 0u)) );
+      REQUIRE_FALSE( summary.canSkip(areas.getAreaContainer(), {"W06000011"}, {"pop"}, std::make_tuple(0u, 0u)) );
+      REQUIRE_FALSE( summary.canSkip(areas.getAreaContainer(), none, {"dens"}, std::make_tuple(0u, 0u)) );
+      REQUIRE_FALSE( summary.canSkip(AreasContainer(), {"W06000011"}, {"dens"}, std::make_tuple(0u, 0u)) );
+
+    } // THEN
+
+    THEN( "the data loaded is the same as when it is imported" ) {
+
+      BethYw::InputFileSource source = {"pairs", "Pairs", path, BethYw::InputFiles::POPDEN.PARSER,
+                                        BethYw::InputFiles::POPDEN.COLS};
+      std::unordered_set<std::string> areasFilter{"W06000011"};
+      std::unordered_set<std::string> measuresFilter{"dens"};
+
+      Areas expected = Areas();
+      BethYw::loadAreas(expected, "datasets/", areasFilter);
+      std::string error;
+      BethYw::importDataset(expected, path, source, areasFilter, measuresFilter,
+                            std::make_tuple(0u, 0u), "", error);
+
+      Areas actual = Areas();
+      BethYw::loadAreas(actual, "datasets/", areasFilter);
+      BethYw::loadDatasets(actual, "", {source}, areasFilter, measuresFilter, std::make_tuple(0u, 0u));
+
+      REQUIRE( actual.toJSON() == expected.toJSON() );
+
+    } // THEN
+
+    std::remove(path.c_str());
+    std::remove((path + BethYw::INDEX_SUFFIX).c_str());
+    std::remove(BethYw::CATALOG_FILE.c_str());
+
+  } // GIVEN
+
+  GIVEN( "a dataset that has been imported in full" ) {
+
+    Areas imported = Areas();
+    std::ifstream stream("datasets/envi0201.json");
+    imported.populate(stream, BethYw::InputFiles::AQI.PARSER, BethYw::InputFiles::AQI.COLS);
+
+    THEN( "its summary is recorded without reading it again" ) {
+
+      DatasetCatalog catalog(catalogPath);
+      DatasetSummary summary;
+      REQUIRE_FALSE( catalog.find("datasets/envi0201.json", BethYw::InputFiles::AQI, summary) );
+
+      catalog.record("datasets/envi0201.json", BethYw::InputFiles::AQI, imported, true);
+      REQUIRE( catalog.find("datasets/envi0201.json", BethYw::InputFiles::AQI, summary) );
+
+      DatasetSummary scanned = DatasetCatalog::scan("datasets/envi0201.json", BethYw::InputFiles::AQI);
+      REQUIRE( summary.valid );
+      REQUIRE( summary.measures == scanned.measures );
+      REQUIRE( summary.areas == scanned.areas );
+      REQUIRE( summary.years == scanned.years );
+      REQUIRE( summary.values == scanned.values );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a dataset file that changes" ) {
+
+    const std::string path = "test22-pop.csv";
+    std::ofstream(path) << "AuthorityCode,2001\nW06000011,1\n";
+
+    DatasetCatalog catalog(catalogPath);
+    REQUIRE( catalog.summarise(path, BethYw::InputFiles::COMPLETE_POP).measures.at("pop") == std::make_pair(2001, 2001) );
+
+    THEN( "it is summarised again" ) {
+
+      std::ofstream(path) << "AuthorityCode,2001,2002\nW06000011,1,2\n";
+      REQUIRE( catalog.summarise(path, BethYw::InputFiles::COMPLETE_POP).measures.at("pop") == std::make_pair(2001, 2002) );
+
+    } // THEN
+
+#if defined(__linux__)
+    THEN( "it is summarised again if it keeps its size and modification time" ) {
+
+      struct stat status;
+      REQUIRE( stat(path.c_str(), &status) == 0 );
+      std::ofstream(path) << "AuthorityCode,2009\nW06000011,1\n";
+      struct timespec times[2] = {status.st_atim, status.st_mtim};
+      REQUIRE( utimensat(AT_FDCWD, path.c_str(), times, 0) == 0 );
+
+      REQUIRE( catalog.summarise(path, BethYw::InputFiles::COMPLETE_POP).measures.at("pop") == std::make_pair(2009, 2009) );
+
+    } // THEN
+#endif
+
+    THEN( "it is never skipped if it cannot be imported" ) {
+
+      std::ofstream(path) << "AuthorityCode,2001,2002\nW06000011,1,x\n";
+      DatasetSummary summary = catalog.summarise(path, BethYw::InputFiles::COMPLETE_POP);
+      REQUIRE_FALSE( summary.valid );
+      REQUIRE_FALSE( summary.canSkip(AreasContainer(), none, {"dens"}, std::make_tuple(0u, 0u)) );
+
+    } // THEN
+
+    std::remove(path.c_str());
+
+  } // GIVEN
+
+  GIVEN( "filters that skip some of the datasets" ) {
+
+    std::vector<std::tuple<std::unordered_set<std::string>,
+                           std::unordered_set<std::string>,
+                           std::tuple<unsigned int, unsigned int>>> filters = {
+      std::make_tuple(none, std::unordered_set<std::string>{"rail"}, std::make_tuple(0u, 0u)),
+      std::make_tuple(std::unordered_set<std::string>{"W06000011"}, std::unordered_set<std::string>{"pop"},
+                      std::make_tuple(2030u, 2040u)),
+      std::make_tuple(none, none, std::make_tuple(1991u, 1991u)),
+      std::make_tuple(std::unordered_set<std::string>{"W92000004", "W06000011"}, none,
+                      std::make_tuple(1990u, 1993u)),
+      std::make_tuple(none, none, std::make_tuple(0u, 0u))
+    };
+
+    THEN( "the data loaded is the same as when every dataset is imported" ) {
+
+      for (const auto &filter : filters) {
+        Areas expected = Areas();
+        BethYw::loadAreas(expected, "datasets/", std::get<0>(filter));
+        for (const auto &source : BethYw::InputFiles::DATASETS) {
+          std::string error;
+          BethYw::importDataset(expected, "datasets/" + source.FILE, source, std::get<0>(filter),
+                                std::get<1>(filter), std::get<2>(filter), "", error);
+        }
+
+        Areas actual = Areas();
+        BethYw::loadAreas(actual, "datasets/", std::get<0>(filter));
+        BethYw::loadDatasets(actual, "datasets/",
+                             std::vector<BethYw::InputFileSource>(BethYw::InputFiles::DATASETS,
+                                                                  BethYw::InputFiles::DATASETS +
+                                                                  BethYw::InputFiles::NUM_DATASETS),
+                             std::get<0>(filter), std::get<1>(filter), std::get<2>(filter));
+
+        REQUIRE( actual.toJSON() == expected.toJSON() );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  std::remove(catalogPath.c_str());
+
+} // SCENARIO
@@ -0,0 +1,283 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../input.h"
+#include "../recordindex.h"
+
+SCENARIO( "the records of a StatsWales JSON file are indexed", "[RecordIndex]" ) {
+
+  const std::vector<BethYw::InputFileSource> sources = {
+    BethYw::InputFiles::POPDEN,
+    BethYw::InputFiles::BIZ,
+    BethYw::InputFiles::AQI,
+    BethYw::InputFiles::TRAINS
+  };
+
+  GIVEN( "the JSON datasets" ) {
+
+    for (const auto &source : sources) {
+
+      AND_GIVEN( "the file " + source.FILE ) {
+
+        const std::string path = "test23-" + source.FILE;
+        {
+          std::ifstream in("datasets/" + source.FILE, std::ios::binary);
+          std::ofstream(path, std::ios::binary) << in.rdbuf();
+        }
+        const std::string indexPath = path + BethYw::INDEX_SUFFIX;
+        std::remove(indexPath.c_str());
+
+        THEN( "the index read back from its sidecar file selects the same records" ) {
+
+          InputMappedFile input(path);
+          StringFilterSet areasFilter{"W06000011", "W92000004", "E12000001"};
+          StringFilterSet measuresFilter{"pop", "rail", "no2", "a"};
+
+          RecordIndex built(indexPath);
+          REQUIRE( built.open(path, input.data(), input.size(), source.COLS) );
+          REQUIRE( std::ifstream(indexPath).is_open() );
+
+          RecordIndex read(indexPath);
+          REQUIRE( read.open(path, input.data(), input.size(), source.COLS) );
+
+          REQUIRE( read.select(&areasFilter, &measuresFilter) == built.select(&areasFilter, &measuresFilter) );
+          REQUIRE( read.select(&areasFilter, nullptr) == built.select(&areasFilter, nullptr) );
+          REQUIRE( read.select(nullptr, &measuresFilter) == built.select(nullptr, &measuresFilter) );
+
+          for (const auto &range : read.select(&areasFilter, nullptr)) {
+            REQUIRE( input.data()[range.first] == '{' );
+            REQUIRE( input.data()[range.second - 1] == '}' );
+          }
+
+        } // THEN
+
+        THEN( "the data imported through the index is the same as from the whole file" ) {
+
+          std::vector<StringFilterSet> areasFilters = {{}, {"W06000011"}, {"W92000004", "E12000001", "W06000024"}};
+          std::vector<StringFilterSet> measuresFilters = {{}, {"pop"}, {"rail", "no2", "a", "dens"}, {"invalid"}};
+          YearFilterTuple yearsFilter = std::make_tuple(2005, 2015);
+
+          for (const auto &areasFilter : areasFilters) {
+            for (const auto &measuresFilter : measuresFilters) {
+              for (JSONBackend backend : {JSONBackend::Scan, JSONBackend::SIMD}) {
+                InputMappedFile expectedInput(path);
+                Areas expected = Areas();
+                expected.setJSONBackend(backend);
+                expected.populate(expectedInput.open(), source.PARSER, source.COLS,
+                                  &areasFilter, &measuresFilter, &yearsFilter);
+
+                InputMappedFile actualInput(path);
+                RecordIndex index(indexPath);
+                REQUIRE( index.open(path, actualInput.data(), actualInput.size(), source.COLS) );
+                Areas actual = Areas();
+                actual.setJSONBackend(backend);
+                actual.populateFromWelshStatsJSON(actualInput.open(), source.COLS,
+                                                  &areasFilter, &measuresFilter, &yearsFilter, &index);
+
+                REQUIRE( actual.toJSON() == expected.toJSON() );
+              }
+            }
+          }
+
+        } // THEN
+
+        std::remove(indexPath.c_str());
+        std::remove(path.c_str());
+
+      } // AND_GIVEN
+
+    }
+
+  } // GIVEN
+
+  GIVEN( "a small StatsWales JSON file" ) {
+
+    const std::string path = "test23-small.json";
+    const std::string indexPath = path + BethYw::INDEX_SUFFIX;
+    std::remove(indexPath.c_str());
+
+    std::ofstream(path) << R"({"value": [
+      {"Localauthority_Code": "W06000011", "Localauthority_ItemName_ENG": "Swansea",
+       "Measure_Code": "Pop", "Measure_ItemName_ENG": "Population", "Year_Code": "2011", "Data": 1},
+      {"Localauthority_Code": "W06000024", "Localauthority_ItemName_ENG": "Merthyr Tydfil",
+       "Measure_Code": "Dens", "Measure_ItemName_ENG": "Density", "Year_Code": "2011", "Data": 2},
+      {"Localauthority_Code": "W06000011", "Localauthority_ItemName_ENG": "Swansea",
+       "Measure_Code": "Dens", "Measure_ItemName_ENG": "Density", "Year_Code": "2011", "Data": 3}
+    ]})";
+
+    THEN( "only the records needed for the filters are selected" ) {
+
+      InputMappedFile input(path);
+      RecordIndex index(indexPath);
+      REQUIRE( index.open(path, input.data(), input.size(), BethYw::InputFiles::POPDEN.COLS) );
+
+      StringFilterSet swansea{"W06000011"};
+      StringFilterSet dens{"dens"};
+      REQUIRE( index.select(&swansea, nullptr).size() == 2 );
+      REQUIRE( index.select(nullptr, nullptr).size() == 3 );
+
+      // The first record of each area is always read, as it creates the area
+      REQUIRE( index.select(&swansea, &dens).size() == 2 );
+      REQUIRE( index.select(nullptr, &dens).size() == 3 );
+      StringFilterSet invalid{"invalid"};
+      REQUIRE( index.select(&swansea, &invalid).size() == 1 );
+
+    } // THEN
+
+    THEN( "the index is built again when the file changes" ) {
+
+      {
+        InputMappedFile input(path);
+        RecordIndex index(indexPath);
+        REQUIRE( index.open(path, input.data(), input.size(), BethYw::InputFiles::POPDEN.COLS) );
+      }
+
+      std::ofstream(path) << R"({"value": [
+        {"Localauthority_Code": "W06000011", "Localauthority_ItemName_ENG": "Swansea",
+         "Measure_Code": "Pop", "Measure_ItemName_ENG": "Population", "Year_Code": "2011", "Data": 1}
+      ]})";
+
+      InputMappedFile input(path);
+      RecordIndex index(indexPath);
+      REQUIRE( index.open(path, input.data(), input.size(), BethYw::InputFiles::POPDEN.COLS) );
+      REQUIRE( index.select(nullptr, nullptr).size() == 1 );
+
+    } // THEN
+
+    THEN( "a sidecar file that has been cut short is not used" ) {
+
+      {
+        InputMappedFile input(path);
+        RecordIndex index(indexPath);
+        REQUIRE( index.open(path, input.data(), input.size(), BethYw::InputFiles::POPDEN.COLS) );
+      }
+      std::string contents;
+      {
+        std::ifstream in(indexPath, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+      }
+      std::ofstream(indexPath, std::ios::binary) << contents.substr(0, contents.size() - 8);
+
+      InputMappedFile input(path);
+      RecordIndex index(indexPath);
+      REQUIRE( index.open(path, input.data(), input.size(), BethYw::InputFiles::POPDEN.COLS) );
+      REQUIRE( index.select(nullptr, nullptr).size() == 3 );
+
+    } // THEN
+
+    THEN( "a file with a record that has no authority code is not indexed" ) {
+
+      std::ofstream(path) << R"({"value": [{"Measure_Code": "Pop", "Year_Code": "2011", "Data": 1}]})";
+
+      InputMappedFile input(path);
+      RecordIndex index(indexPath);
+      REQUIRE_FALSE( index.open(path, input.data(), input.size(), BethYw::InputFiles::POPDEN.COLS) );
+
+    } // THEN
+
+    std::remove(indexPath.c_str());
+    std::remove(path.c_str());
+
+  } // GIVEN
+
+#if defined(__linux__)
+  GIVEN( "a copy of a dataset that is indexed, and then has a record in its middle changed" ) {
+
+    const std::string path = "test23-rewritten.json";
+    const std::string indexPath = path + BethYw::INDEX_SUFFIX;
+    std::remove(indexPath.c_str());
+
+    std::string contents;
+    {
+      std::ifstream in("datasets/" + BethYw::InputFiles::POPDEN.FILE, std::ios::binary);
+      contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::ofstream(path, std::ios::binary) << contents;
+    {
+      InputMappedFile input(path);
+      RecordIndex index(indexPath);
+      REQUIRE( index.open(path, input.data(), input.size(), BethYw::InputFiles::POPDEN.COLS) );
+    }
+
+    // The change is the same size, and out of the start and end of the file
+    // that are hashed
+    const std::size_t changed = contents.find("\"W06000006\"", contents.size() / 2);
+    REQUIRE( changed != std::string::npos );
+    REQUIRE( changed > 64 * 1024 );
+    REQUIRE( changed < contents.size() - 64 * 1024 );
+    contents.replace(changed, 11, "\"W06000099\"");
+
+    struct stat status;
+    REQUIRE( stat(path.c_str(), &status) == 0 );
+    StringFilterSet areasFilter{"W06000099"};
+
+    THEN( "the index is built again if the file is rewritten in the same second" ) {
+
+      std::ofstream(path, std::ios::binary) << contents;
+      struct timespec times[2] = {status.st_atim, status.st_mtim};
+      times[1].tv_nsec = (times[1].tv_nsec + 1) % 1000000000;
+      REQUIRE( utimensat(AT_FDCWD, path.c_str(), times, 0) == 0 );
+
+      InputMappedFile input(path);
+      RecordIndex index(indexPath);
+      REQUIRE( index.open(path, input.data(), input.size(), BethYw::InputFiles::POPDEN.COLS) );
+      REQUIRE( index.select(&areasFilter, nullptr).size() == 1 );
+
+    } // THEN
+
+    THEN( "the index is built again if the file is replaced by a copy with its modification time" ) {
+
+      const std::string copyPath = path + ".copy";
+      std::ofstream(copyPath, std::ios::binary) << contents;
+      struct timespec times[2] = {status.st_atim, status.st_mtim};
+      REQUIRE( utimensat(AT_FDCWD, copyPath.c_str(), times, 0) == 0 );
+      REQUIRE( std::rename(copyPath.c_str(), path.c_str()) == 0 );
+
+      InputMappedFile input(path);
+      RecordIndex index(indexPath);
+      REQUIRE( index.open(path, input.data(), input.size(), BethYw::InputFiles::POPDEN.COLS) );
+      REQUIRE( index.select(&areasFilter, nullptr).size() == 1 );
+
+      Areas areas = Areas();
+      areas.populateFromWelshStatsJSON(input.open(), BethYw::InputFiles::POPDEN.COLS,
+                                       &areasFilter, nullptr, nullptr, &index);
+      REQUIRE( areas.size() == 1 );
+      REQUIRE( areas.getArea("W06000099").getName("eng") == "Wrexham" );
+
+    } // THEN
+
+    std::remove(indexPath.c_str());
+    std::remove(path.c_str());
+
+  } // GIVEN
+#endif
+
+} // SCENARIO
@@ -0,0 +1,136 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../authoritycodes.h"
+
+SCENARIO( "authority codes are interned as dense IDs", "[AuthorityCodes]" ) {
+
+  GIVEN( "a table with no area filter" ) {
+
+    AuthorityCodes codes;
+
+    THEN( "each code is given the next ID the first time it is seen" ) {
+
+      REQUIRE( codes.size() == 0 );
+      REQUIRE( codes.intern("W06000011") == 0 );
+      REQUIRE( codes.intern("W06000024") == 1 );
+      REQUIRE( codes.intern("W06000011") == 0 );
+      REQUIRE( codes.size() == 2 );
+
+      REQUIRE( codes.code(0) == "W06000011" );
+      REQUIRE( codes.code(1) == "W06000024" );
+      REQUIRE_THROWS_AS( codes.code(2), std::out_of_range );
+
+      AuthorityCodes::ID id;
+      REQUIRE( codes.find("W06000024", id) );
+      REQUIRE( id == 1 );
+      REQUIRE_FALSE( codes.find("W06000001", id) );
+      REQUIRE( codes.size() == 2 );
+
+    } // THEN
+
+    THEN( "every code passes the filter" ) {
+
+      REQUIRE( codes.accepted(codes.intern("W06000011")) );
+      REQUIRE( codes.accepted(codes.intern("E12000001")) );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a table with an area filter" ) {
+
+    StringFilterSet areasFilter{"W06000024", "W06000011"};
+    AuthorityCodes codes(&areasFilter);
+
+    THEN( "the codes of the filter are interned first, in order" ) {
+
+      REQUIRE( codes.size() == 2 );
+      REQUIRE( codes.code(0) == "W06000011" );
+      REQUIRE( codes.code(1) == "W06000024" );
+
+    } // THEN
+
+    THEN( "only the codes of the filter pass it" ) {
+
+      REQUIRE( codes.accepted(codes.intern("W06000024")) );
+      REQUIRE( codes.accepted(codes.intern("W06000011")) );
+      REQUIRE_FALSE( codes.accepted(codes.intern("W06000001")) );
+      REQUIRE_FALSE( codes.accepted(codes.intern("E12000001")) );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a StatsWales JSON file with records for areas in and out of a filter" ) {
+
+    std::string json = R"({"value": [
+      {"Localauthority_Code": "W06000011", "Localauthority_ItemName_ENG": "Swansea",
+       "Measure_Code": "Pop", "Measure_ItemName_ENG": "Population", "Year_Code": "2011", "Data": 1},
+      {"Localauthority_Code": "W06000024", "Localauthority_ItemName_ENG": "Merthyr Tydfil",
+       "Measure_Code": "Pop", "Measure_ItemName_ENG": "Population", "Year_Code": "2011", "Data": 2},
+      {"Localauthority_Code": "W06000011", "Localauthority_ItemName_ENG": "Abertawe",
+       "Measure_Code": "Pop", "Measure_ItemName_ENG": "Population", "Year_Code": "2012", "Data": 3},
+      {"Localauthority_Code": "W06000001", "Localauthority_ItemName_ENG": "Isle of Anglesey",
+       "Measure_Code": "Pop", "Measure_ItemName_ENG": "Population", "Year_Code": "2012", "Data": 4}
+    ]})";
+
+    StringFilterSet areasFilter{"W06000011", "W06000001"};
+    StringFilterSet measuresFilter{};
+    YearFilterTuple yearsFilter = std::make_tuple(0, 0);
+
+    THEN( "every backend imports only the areas of the filter, named by their first record" ) {
+
+      for (JSONBackend backend : {JSONBackend::DOM, JSONBackend::SAX, JSONBackend::Scan, JSONBackend::SIMD}) {
+        std::istringstream stream(json);
+        Areas areas = Areas();
+        areas.setJSONBackend(backend);
+        areas.populateFromWelshStatsJSON(stream, BethYw::InputFiles::POPDEN.COLS,
+                                         &areasFilter, &measuresFilter, &yearsFilter);
+
+        REQUIRE( areas.size() == 2 );
+        REQUIRE( areas.getArea("W06000011").getName("eng") == "Swansea" );
+        REQUIRE( areas.getArea("W06000011").getLocalAuthorityCode() == "W06000011" );
+        REQUIRE( areas.getArea("W06000011").getMeasure("pop").size() == 2 );
+        REQUIRE( areas.getArea("W06000001").getMeasure("pop").getValue(2012) == 4 );
+        REQUIRE_THROWS_AS( areas.getArea("W06000024"), std::out_of_range );
+      }
+
+    } // THEN
+
+    THEN( "areas that already exist are added to, and keep their names" ) {
+
+      Area existing("W06000011");
+      existing.setName("eng", "City and County of Swansea");
+
+      std::istringstream stream(json);
+      Areas areas = Areas();
+      areas.setArea("W06000011", existing);
+      areas.populateFromWelshStatsJSON(stream, BethYw::InputFiles::POPDEN.COLS,
+                                       &areasFilter, &measuresFilter, &yearsFilter);
+
+      REQUIRE( areas.size() == 2 );
+      REQUIRE( areas.getArea("W06000011").getName("eng") == "City and County of Swansea" );
+      REQUIRE( areas.getArea("W06000011").getMeasure("pop").getValue(2012) == 3 );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,141 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "../measure.h"
+#include "../yearvalues.h"
+
+SCENARIO( "the values of a measure are stored by year", "[YearValues]" ) {
+
+  GIVEN( "values for a run of years, set out of order" ) {
+
+    YearValues values;
+    values.set(2012, 3);
+    values.set(2010, 1);
+    values.set(2015, 6);
+    values.set(2011, 2);
+    values.set(2012, 4);
+
+    THEN( "they are kept in an array" ) {
+
+      REQUIRE( values.isDense() );
+      REQUIRE( values.size() == 4 );
+      REQUIRE_FALSE( values.empty() );
+
+    } // THEN
+
+    THEN( "each year has its last value, and the years between have none" ) {
+
+      double value = 0;
+      REQUIRE( values.find(2012, value) );
+      REQUIRE( value == 4 );
+      REQUIRE( values.find(2010, value) );
+      REQUIRE( value == 1 );
+      REQUIRE_FALSE( values.find(2013, value) );
+      REQUIRE_FALSE( values.find(2009, value) );
+      REQUIRE_FALSE( values.find(2016, value) );
+
+    } // THEN
+
+    THEN( "they are iterated in order of year" ) {
+
+      std::vector<std::pair<int, double>> iterated(values.begin(), values.end());
+      std::vector<std::pair<int, double>> expected = {{2010, 1}, {2011, 2}, {2012, 4}, {2015, 6}};
+      REQUIRE( iterated == expected );
+      REQUIRE( values.front() == std::make_pair(2010, 1.0) );
+      REQUIRE( values.back() == std::make_pair(2015, 6.0) );
+      REQUIRE( values.toMap() == std::map<int, double>(expected.begin(), expected.end()) );
+
+    } // THEN
+
+    AND_GIVEN( "a value for a year far from the others" ) {
+
+      values.set(0, 10);
+
+      THEN( "they are moved into a map, and nothing else changes" ) {
+
+        REQUIRE_FALSE( values.isDense() );
+        REQUIRE( values.size() == 5 );
+        std::vector<std::pair<int, double>> iterated(values.begin(), values.end());
+        std::vector<std::pair<int, double>> expected = {{0, 10}, {2010, 1}, {2011, 2}, {2012, 4}, {2015, 6}};
+        REQUIRE( iterated == expected );
+        REQUIRE( values.front() == std::make_pair(0, 10.0) );
+        REQUIRE( values.back() == std::make_pair(2015, 6.0) );
+
+        double value = 0;
+        REQUIRE( values.find(2011, value) );
+        REQUIRE( value == 2 );
+        REQUIRE_FALSE( values.find(2013, value) );
+
+      } // THEN
+
+      THEN( "they are equal to the same values kept in an array" ) {
+
+        YearValues other;
+        for (auto value : values) {
+          other.set(value.first, value.second);
+        }
+        REQUIRE( other == values );
+
+        YearValues dense;
+        dense.set(2010, 1);
+        REQUIRE_FALSE( dense == values );
+
+      } // THEN
+
+    } // AND_GIVEN
+
+  } // GIVEN
+
+  GIVEN( "no values" ) {
+
+    YearValues values;
+
+    THEN( "there is nothing to iterate, and no first or last year" ) {
+
+      REQUIRE( values.empty() );
+      REQUIRE( values.begin() == values.end() );
+      REQUIRE_THROWS_AS( values.front(), std::out_of_range );
+      REQUIRE_THROWS_AS( values.back(), std::out_of_range );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a Measure with values that are not dense" ) {
+
+    Measure measure("pop", "Population");
+    measure.setValue(2019, 4);
+    measure.setValue(1900, 1);
+    measure.setValue(1950, 2);
+    measure.setValue(2000, 3);
+
+    THEN( "its statistics are those of the first and last year" ) {
+
+      REQUIRE( measure.size() == 4 );
+      REQUIRE( measure.getValue(1950) == 2 );
+      REQUIRE_THROWS_AS( measure.getValue(1951), std::out_of_range );
+      REQUIRE( measure.getDifference() == 3 );
+      REQUIRE( measure.getDifferenceAsPercentage() == 300 );
+      REQUIRE( measure.getAverage() == 2.5 );
+      REQUIRE( measure.getAllValue() == std::map<int, double>{{1900, 1}, {1950, 2}, {2000, 3}, {2019, 4}} );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,125 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <string>
+#include <utility>
+
+#include "../areas.h"
+#include "../area.h"
+#include "../measure.h"
+
+SCENARIO( "areas and measures can be moved in, and found or created in place", "[Areas][Area]" ) {
+
+  GIVEN( "a Measure with values" ) {
+
+    Measure measure("Pop", "Population");
+    measure.setValue(2011, 1);
+    measure.setValue(2012, 2);
+
+    THEN( "it can be moved into an Area" ) {
+
+      Area area("W06000011");
+      area.setMeasure("POP", std::move(measure));
+
+      REQUIRE( area.size() == 1 );
+      REQUIRE( area.getMeasure("pop").getLabel() == "Population" );
+      REQUIRE( area.getMeasure("pop").getValue(2012) == 2 );
+
+    } // THEN
+
+    THEN( "it can still be copied into an Area" ) {
+
+      Area area("W06000011");
+      area.setMeasure("pop", measure);
+
+      REQUIRE( area.getMeasure("pop") == measure );
+      REQUIRE( measure.size() == 2 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an Area with a Measure" ) {
+
+    Area area("W06000011");
+    area.setName("eng", "Swansea");
+    area.emplaceMeasure("Pop", "Population").setValue(2011, 1);
+
+    THEN( "finding or creating the Measure again keeps its label and values" ) {
+
+      Measure &measure = area.emplaceMeasure("POP", "Another label");
+      REQUIRE( &measure == &area.getMeasure("pop") );
+      REQUIRE( measure.getLabel() == "Population" );
+      REQUIRE( measure.getValue(2011) == 1 );
+      REQUIRE( area.size() == 1 );
+
+    } // THEN
+
+    THEN( "another Measure is created with its label and no values" ) {
+
+      Measure &measure = area.emplaceMeasure("dens", "Population density");
+      REQUIRE( measure.getCodename() == "dens" );
+      REQUIRE( measure.getLabel() == "Population density" );
+      REQUIRE( measure.size() == 0 );
+      REQUIRE( area.getMeasures().size() == 2 );
+
+    } // THEN
+
+    THEN( "its names and measures can be read without copying them" ) {
+
+      REQUIRE( &area.getNames() == &area.lang );
+      REQUIRE( &area.getMeasures() == &area.measures );
+      REQUIRE( area.getNames().at("eng") == "Swansea" );
+
+    } // THEN
+
+    AND_GIVEN( "an Areas object" ) {
+
+      Areas areas = Areas();
+
+      THEN( "the Area can be moved into it" ) {
+
+        areas.setArea("W06000011", std::move(area));
+        REQUIRE( areas.size() == 1 );
+        REQUIRE( areas.getArea("W06000011").getName("eng") == "Swansea" );
+        REQUIRE( areas.getArea("W06000011").getMeasure("pop").getValue(2011) == 1 );
+
+      } // THEN
+
+      THEN( "finding or creating an Area keeps one that exists" ) {
+
+        areas.setArea("W06000011", area);
+        Area &found = areas.emplaceArea("W06000011");
+        REQUIRE( &found == &areas.getArea("W06000011") );
+        REQUIRE( found.getName("eng") == "Swansea" );
+        REQUIRE( areas.size() == 1 );
+
+      } // THEN
+
+      THEN( "finding or creating an Area creates one with its code" ) {
+
+        Area &created = areas.emplaceArea("W06000024");
+        REQUIRE( created.getLocalAuthorityCode() == "W06000024" );
+        REQUIRE( created.size() == 0 );
+        REQUIRE( areas.size() == 1 );
+
+        const Areas &constAreas = areas;
+        REQUIRE( constAreas.getAreaContainer().count("W06000024") == 1 );
+
+      } // THEN
+
+    } // AND_GIVEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,284 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../input.h"
+#include "../recordbatch.h"
+
+/*
+  A RecordSink that keeps a copy of every batch it is given.
+*/
+class CopyingSink : public RecordSink {
+public:
+  std::vector<RecordBatch> batches;
+
+  void consume(const RecordBatch &batch) override {
+    batches.push_back(batch);
+  }
+};
+
+SCENARIO( "decoded records can be added to Areas in a batch", "[RecordBatch]" ) {
+
+  GIVEN( "a batch with an area and measure added more than once" ) {
+
+    RecordBatch batch;
+    RecordBatch::ID swansea = batch.addArea("W06000011", "eng", "Swansea");
+    RecordBatch::ID pop = batch.addMeasure(swansea, "pop", "Population");
+    batch.addValue(pop, 2011, 1);
+    batch.addValue(pop, 2012, 2);
+
+    REQUIRE( batch.addArea("W06000011", "eng", "Abertawe") == swansea );
+    REQUIRE( batch.addArea("W06000011") == swansea );
+    REQUIRE( batch.addMeasure(swansea, "pop", "Another label") == pop );
+    batch.addValue(pop, 2011, 3);
+
+    THEN( "each area and measure is only held once" ) {
+
+      REQUIRE( batch.getAreas().size() == 1 );
+      REQUIRE( batch.getMeasures().size() == 1 );
+      REQUIRE( batch.size() == 3 );
+
+      RecordBatch::ID found;
+      REQUIRE( batch.findArea("W06000011", found) );
+      REQUIRE( found == swansea );
+      REQUIRE_FALSE( batch.findArea("W06000024", found) );
+      REQUIRE( batch.findMeasure(swansea, "pop", found) );
+      REQUIRE_FALSE( batch.findMeasure(swansea, "dens", found) );
+
+    } // THEN
+
+    THEN( "ingesting it keeps the first name and label, and the last value" ) {
+
+      Areas areas = Areas();
+      areas.ingest(batch);
+
+      REQUIRE( areas.size() == 1 );
+      Area &area = areas.getArea("W06000011");
+      REQUIRE( area.getLocalAuthorityCode() == "W06000011" );
+      REQUIRE( area.getName("eng") == "Swansea" );
+      REQUIRE( area.getMeasure("pop").getLabel() == "Population" );
+      REQUIRE( area.getMeasure("pop").getValue(2011) == 3 );
+      REQUIRE( area.getMeasure("pop").getValue(2012) == 2 );
+
+    } // THEN
+
+    THEN( "ingesting it into existing areas only adds the values" ) {
+
+      Areas areas = Areas();
+      Area &area = areas.emplaceArea("W06000011");
+      area.setName("eng", "City and County of Swansea");
+      area.emplaceMeasure("pop", "Population (mid-year)").setValue(2010, 0);
+      areas.ingest(batch);
+
+      REQUIRE( area.getName("eng") == "City and County of Swansea" );
+      REQUIRE( area.getMeasure("pop").getLabel() == "Population (mid-year)" );
+      REQUIRE( area.getMeasure("pop").size() == 3 );
+
+    } // THEN
+
+    THEN( "its values are held in columns of the same length" ) {
+
+      REQUIRE( batch.getMeasureColumn() == std::vector<RecordBatch::ID>({pop, pop, pop}) );
+      REQUIRE( batch.getYearColumn() == std::vector<int>({2011, 2012, 2011}) );
+      REQUIRE( batch.getValueColumn() == std::vector<double>({1, 2, 3}) );
+
+    } // THEN
+
+    THEN( "clearing it leaves it empty" ) {
+
+      batch.clear();
+      REQUIRE( batch.empty() );
+      REQUIRE( batch.size() == 0 );
+      REQUIRE( batch.getYearColumn().empty() );
+      REQUIRE( batch.capacity() == RecordBatch::DEFAULT_CAPACITY );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a batch with a capacity of two values" ) {
+
+    RecordBatch batch(2);
+    RecordBatch::ID pop = batch.addMeasure(batch.addArea("W06000011"), "pop", "Population");
+
+    THEN( "it is full once it has two values" ) {
+
+      REQUIRE( batch.capacity() == 2 );
+      batch.addValue(pop, 2011, 1);
+      REQUIRE_FALSE( batch.full() );
+      batch.addValue(pop, 2012, 2);
+      REQUIRE( batch.full() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a batch with an area added without a name" ) {
+
+    RecordBatch batch;
+    batch.addMeasure(batch.addArea("W06000024"), "dens", "Population density");
+
+    THEN( "it is created without a code or names, as by AuthorityByYearCSV" ) {
+
+      Areas areas = Areas();
+      areas.ingest(batch);
+
+      REQUIRE( areas.getArea("W06000024").getLocalAuthorityCode() == "" );
+      REQUIRE( areas.getArea("W06000024").lang.empty() );
+      REQUIRE( areas.getArea("W06000024").getMeasure("dens").size() == 0 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a batch with a replaced area" ) {
+
+    RecordBatch batch;
+    RecordBatch::ID area = batch.replaceArea("W06000011");
+    batch.setName(area, "eng", "Swansea");
+    batch.setName(area, "cym", "Abertawe");
+
+    THEN( "it replaces an existing area, and its measures" ) {
+
+      Areas areas = Areas();
+      areas.emplaceArea("W06000011").emplaceMeasure("pop", "Population").setValue(2011, 1);
+      areas.ingest(batch);
+
+      REQUIRE( areas.getArea("W06000011").getName("cym") == "Abertawe" );
+      REQUIRE( areas.getArea("W06000011").size() == 0 );
+
+    } // THEN
+
+    THEN( "it cannot be replaced again once it has measures" ) {
+
+      batch.addMeasure(area, "pop", "Population");
+      REQUIRE_THROWS_AS( batch.replaceArea("W06000011"), std::logic_error );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a CSV file with a malformed value after some that are not" ) {
+
+    std::istringstream stream("AuthorityCode,2011,2012\n"
+                              "W06000011,1,2\n"
+                              "W06000024,3,x\n");
+
+    THEN( "the values before it are still imported" ) {
+
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populateFromAuthorityByYearCSV(stream, BethYw::InputFiles::COMPLETE_POP.COLS,
+                                                              nullptr, nullptr, nullptr),
+                         std::runtime_error );
+
+      REQUIRE( areas.size() == 2 );
+      REQUIRE( areas.getArea("W06000011").getMeasure("pop").size() == 2 );
+      REQUIRE( areas.getArea("W06000024").getMeasure("pop").getValue(2011) == 3 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a StatsWales JSON file with a malformed year after some records that are not" ) {
+
+    std::string json = R"({"value": [
+      {"Localauthority_Code": "W06000011", "Localauthority_ItemName_ENG": "Swansea",
+       "Measure_Code": "Pop", "Measure_ItemName_ENG": "Population", "Year_Code": "2011", "Data": 1},
+      {"Localauthority_Code": "W06000024", "Localauthority_ItemName_ENG": "Merthyr Tydfil",
+       "Measure_Code": "Pop", "Measure_ItemName_ENG": "Population", "Year_Code": "x", "Data": 2}
+    ]})";
+
+    THEN( "every backend imports the records before it" ) {
+
+      for (JSONBackend backend : {JSONBackend::DOM, JSONBackend::SAX, JSONBackend::Scan, JSONBackend::SIMD}) {
+        std::istringstream stream(json);
+        Areas areas = Areas();
+        areas.setJSONBackend(backend);
+        REQUIRE_THROWS_AS( areas.populateFromWelshStatsJSON(stream, BethYw::InputFiles::POPDEN.COLS,
+                                                            nullptr, nullptr, nullptr),
+                           std::runtime_error );
+
+        REQUIRE( areas.getArea("W06000011").getName("eng") == "Swansea" );
+        REQUIRE( areas.getArea("W06000011").getMeasure("pop").getValue(2011) == 1 );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "the parsers of Areas can pass the records they read to any RecordSink", "[RecordBatch][RecordSink]" ) {
+
+  GIVEN( "a sink that keeps the batches it is given, and one that adds them to Areas" ) {
+
+    CopyingSink copies;
+    Areas areas = Areas();
+    AreasSink sink(areas.getAreaContainer());
+
+    THEN( "areas.csv and a dataset passed to either give the same Areas as populate()" ) {
+
+      Areas expected = Areas();
+      for (RecordSink *target : std::vector<RecordSink *>({&copies, &sink})) {
+        {
+          InputFile input("datasets/areas.csv");
+          areas.populate(input.open(), BethYw::AuthorityCodeCSV, BethYw::InputFiles::AREAS.COLS, *target);
+        }
+        {
+          InputFile input("datasets/" + BethYw::InputFiles::POPDEN.FILE);
+          areas.populate(input.open(), BethYw::InputFiles::POPDEN.PARSER, BethYw::InputFiles::POPDEN.COLS,
+                         *target);
+        }
+      }
+      {
+        InputFile input("datasets/areas.csv");
+        expected.populate(input.open(), BethYw::AuthorityCodeCSV, BethYw::InputFiles::AREAS.COLS);
+      }
+      {
+        InputFile input("datasets/" + BethYw::InputFiles::POPDEN.FILE);
+        expected.populate(input.open(), BethYw::InputFiles::POPDEN.PARSER, BethYw::InputFiles::POPDEN.COLS);
+      }
+
+      REQUIRE( areas.toJSON() == expected.toJSON() );
+
+      REQUIRE( copies.batches.size() >= 2 );
+      Areas replayed = Areas();
+      for (const RecordBatch &batch : copies.batches) {
+        REQUIRE( batch.getMeasureColumn().size() == batch.size() );
+        REQUIRE( batch.getYearColumn().size() == batch.size() );
+        replayed.ingest(batch);
+      }
+      REQUIRE( replayed.toJSON() == expected.toJSON() );
+
+    } // THEN
+
+    THEN( "the sink is asked whether it has an area before its name is passed to it" ) {
+
+      areas.emplaceArea("W06000011").emplaceMeasure("pop", "Population");
+      REQUIRE( sink.contains("W06000011") );
+      REQUIRE( sink.contains("W06000011", "pop") );
+      REQUIRE_FALSE( sink.contains("W06000011", "dens") );
+      REQUIRE_FALSE( sink.contains("W06000024") );
+      REQUIRE_FALSE( copies.contains("W06000011") );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
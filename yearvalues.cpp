@@ -0,0 +1,265 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the implementation of the YearValues class. See the
+  header file for how the values are laid out.
+*/
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "yearvalues.h"
+
+/*
+  The values are only moved into a std::map if the years from the first to
+  the last would span more than this many elements of the array...
+*/
+static const long long DENSE_MIN_SPAN = 64;
+
+/*
+  ...and more than this many elements for each value.
+*/
+static const long long DENSE_MAX_SPAN_PER_VALUE = 4;
+
+/*
+  Construct an empty set of values.
+*/
+YearValues::YearValues() : base(0), count(0), sparse(false) {}
+
+/*
+  This function moves the values out of the array and into a std::map.
+*/
+void YearValues::makeSparse(){
+    for(auto value : *this){
+        sparseValues.emplace_hint(sparseValues.end(), value);
+    }
+    values.clear();
+    values.shrink_to_fit();
+    present.clear();
+    present.shrink_to_fit();
+    sparse = true;
+}
+
+/*
+  This function sets the value for a year, replacing any value the year
+  already has.
+
+  @param year
+    The year
+
+  @param value
+    The value for the year
+*/
+void YearValues::set(int year, double value){
+    if(sparse){
+        sparseValues[year] = value;
+        return;
+    }
+
+    if(values.empty()){
+        base = year;
+    } else {
+        long long first = std::min<long long>(base, year);
+        long long last = std::max<long long>(base + static_cast<long long>(values.size()) - 1, year);
+        long long span = last - first + 1;
+        if(span > DENSE_MIN_SPAN &&
+           span > DENSE_MAX_SPAN_PER_VALUE * static_cast<long long>(count + 1)){
+            makeSparse();
+            sparseValues[year] = value;
+            return;
+        }
+    }
+
+    if(year < base){
+        std::size_t shift = static_cast<std::size_t>(static_cast<long long>(base) - year);
+        values.insert(values.begin(), shift, 0.0);
+        present.insert(present.begin(), shift, false);
+        base = year;
+    }
+
+    std::size_t index = static_cast<std::size_t>(static_cast<long long>(year) - base);
+    if(index >= values.size()){
+        values.resize(index + 1, 0.0);
+        present.resize(index + 1, false);
+    }
+    if(!present[index]){
+        present[index] = true;
+        count++;
+    }
+    values[index] = value;
+}
+
+/*
+  This function finds the value for a year.
+
+  @param year
+    The year
+
+  @param value
+    Set to the value for the year, if it has one
+
+  @return
+    true if the year has a value, false otherwise
+*/
+bool YearValues::find(int year, double &value) const{
+    if(sparse){
+        auto it = sparseValues.find(year);
+        if(it == sparseValues.end()){
+            return false;
+        }
+        value = it->second;
+        return true;
+    }
+
+    long long index = static_cast<long long>(year) - base;
+    if(index < 0 || index >= static_cast<long long>(values.size()) || !present[index]){
+        return false;
+    }
+    value = values[index];
+    return true;
+}
+
+/*
+  This function gets the number of years with a value.
+
+  @return
+    The number of values
+*/
+std::size_t YearValues::size() const{
+    return sparse ? sparseValues.size() : count;
+}
+
+/*
+  This function tests whether no year has a value.
+
+  @return
+    true if there are no values, false otherwise
+*/
+bool YearValues::empty() const{
+    return size() == 0;
+}
+
+/*
+  This function tests whether the values are kept in an array, rather than a
+  std::map.
+
+  @return
+    true if the values are dense, false otherwise
+*/
+bool YearValues::isDense() const{
+    return !sparse;
+}
+
+/*
+  This function gets an iterator to the value of the first year.
+
+  @return
+    An iterator over pairs of a year and its value, in order of year
+*/
+YearValues::const_iterator YearValues::begin() const{
+    return const_iterator(this, 0, sparse ? sparseValues.begin() : sparseValues.end());
+}
+
+/*
+  This function gets an iterator to just after the value of the last year.
+
+  @return
+    The end iterator
+*/
+YearValues::const_iterator YearValues::end() const{
+    return const_iterator(this, sparse ? 0 : values.size(), sparseValues.end());
+}
+
+/*
+  This function gets the first year and its value.
+
+  @return
+    A pair of the first year and its value
+
+  @throws
+    std::out_of_range if there are no values
+*/
+std::pair<int, double> YearValues::front() const{
+    if(empty()){
+        throw std::out_of_range("No values");
+    }
+    if(sparse){
+        return *sparseValues.begin();
+    }
+    // The array never extends beyond the first and last year with a value
+    return std::make_pair(base, values.front());
+}
+
+/*
+  This function gets the last year and its value.
+
+  @return
+    A pair of the last year and its value
+
+  @throws
+    std::out_of_range if there are no values
+*/
+std::pair<int, double> YearValues::back() const{
+    if(empty()){
+        throw std::out_of_range("No values");
+    }
+    if(sparse){
+        return *sparseValues.rbegin();
+    }
+    return std::make_pair(base + static_cast<int>(values.size()) - 1, values.back());
+}
+
+/*
+  This function copies the values into a std::map.
+
+  @return
+    A map of each year to its value
+*/
+std::map<int, double> YearValues::toMap() const{
+    if(sparse){
+        return sparseValues;
+    }
+    std::map<int, double> map;
+    for(auto value : *this){
+        map.emplace_hint(map.end(), value);
+    }
+    return map;
+}
+
+/*
+  Overload the == operator for two YearValues objects. They are equal when
+  they have values for the same years, and the values are equal, however
+  they are laid out.
+
+  @param lhs
+    A YearValues object
+
+  @param rhs
+    A second YearValues object
+
+  @return
+    true if both have the same values; false otherwise
+*/
+bool operator==(const YearValues &lhs, const YearValues &rhs){
+    if(lhs.size() != rhs.size()){
+        return false;
+    }
+    auto it = lhs.begin();
+    for(auto value : rhs){
+        if(!(*it == value)){
+            return false;
+        }
+        ++it;
+    }
+    return true;
+}
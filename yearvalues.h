@@ -0,0 +1,123 @@
+#ifndef YEARVALUES_H_
+#define YEARVALUES_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 690826
+
+  This file contains the declaration of the YearValues class, which stores
+  the values of a Measure by year.
+
+  The values of a measure are almost always for a short run of consecutive
+  years, so they are kept in an array indexed by the year less the first
+  year, with a bitmap of which years have a value, rather than in a node of a
+  tree each. If the years become too spread out for this to be worthwhile
+  (e.g. a single value for the year 0 among values for the 2010s), the values
+  are moved into a std::map instead, and stay there.
+
+  Either way, the values are iterated in order of year, as pairs of the year
+  and its value, just like a std::map<int, double>.
+ */
+
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <utility>
+#include <vector>
+
+class YearValues {
+private:
+  // The year of the first element of values, when they are dense
+  int base;
+  std::vector<double> values;
+  std::vector<bool> present;
+  std::size_t count;
+
+  // The values, once the years are too spread out to be kept in an array
+  bool sparse;
+  std::map<int, double> sparseValues;
+
+  void makeSparse();
+
+public:
+  class const_iterator {
+  private:
+    const YearValues *owner;
+    std::size_t index;
+    std::map<int, double>::const_iterator it;
+
+    void skipAbsent() {
+      while (index < owner->values.size() && !owner->present[index]) {
+        index++;
+      }
+    }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::pair<int, double>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type *;
+    using reference = value_type;
+
+    const_iterator(const YearValues *owner, std::size_t index, std::map<int, double>::const_iterator it)
+        : owner(owner), index(index), it(it) {
+      if (!owner->sparse) {
+        skipAbsent();
+      }
+    }
+
+    value_type operator*() const {
+      if (owner->sparse) {
+        return *it;
+      }
+      return value_type(owner->base + static_cast<int>(index), owner->values[index]);
+    }
+
+    const_iterator &operator++() {
+      if (owner->sparse) {
+        ++it;
+      } else {
+        index++;
+        skipAbsent();
+      }
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator before = *this;
+      ++*this;
+      return before;
+    }
+
+    bool operator==(const const_iterator &other) const {
+      return index == other.index && it == other.it;
+    }
+
+    bool operator!=(const const_iterator &other) const {
+      return !(*this == other);
+    }
+  };
+
+  YearValues();
+
+  void set(int year, double value);
+  bool find(int year, double &value) const;
+
+  std::size_t size() const;
+  bool empty() const;
+  bool isDense() const;
+
+  const_iterator begin() const;
+  const_iterator end() const;
+  std::pair<int, double> front() const;
+  std::pair<int, double> back() const;
+
+  std::map<int, double> toMap() const;
+
+  friend bool operator==(const YearValues &lhs, const YearValues &rhs);
+};
+
+#endif // YEARVALUES_H_